@@ -0,0 +1,59 @@
+#ifndef AERO_DATABASE_H
+#define AERO_DATABASE_H
+
+#include <string>
+#include <memory>
+#include "lookup_table.h"
+
+/*
+ * Аэродинамическая база ЛА: Cxa и Cya_alpha (на радиан, как во встроенных
+ * таблицах) по числу Маха, углу атаки и высоте.
+ *
+ * Текстовый файл (строки с '#' пропускаются):
+ *   axis M 0.01 0.55 0.8 ...      - обязательная ось
+ *   axis alpha -10 -5 0 5 10      - необязательная, градусы
+ *   axis H 0 10000 20000          - необязательная, м
+ *   M [alpha] [H] Cxa Cya_alpha   - по строке на каждый узел сетки, в любом порядке
+ * Оси задаются в порядке M, alpha, H до строк узлов; узлы строго возрастают.
+ *
+ * После разбора рядом записывается двоичный кэш <файл>.bin. При следующих
+ * загрузках, если размер и время изменения текстового файла совпадают
+ * с записанными в кэше, таблица отображается в память без разбора, поэтому
+ * время запуска не зависит от размера базы.
+ */
+class AeroDatabase {
+public:
+    static const size_t MAX_AXES = 3;
+
+    /**
+     * @throws std::runtime_error если файл не открыт или данные некорректны
+     */
+    static std::shared_ptr<const AeroDatabase> load(const std::string& filename);
+
+    /**
+     * @param alpha_deg - угол атаки, град (не используется без оси alpha)
+     * @param altitude - высота, м (не используется без оси H)
+     * @param intervals - курсоры интервалов по осям (MAX_AXES значений) или nullptr
+     */
+    void evaluate(double M, double alpha_deg, double altitude,
+                  double& Cxa, double& Cya_alpha, size_t* intervals = nullptr) const;
+
+    bool hasAlpha() const { return (axis_mask & AXIS_ALPHA) != 0; }
+    bool hasAltitude() const { return (axis_mask & AXIS_H) != 0; }
+    size_t nodeCount() const { return table.nodeCount(); }
+    bool fromCache() const { return from_cache; }
+
+    // Дописывает в out байты, однозначно задающие базу (для ключей кэша результатов)
+    void appendContent(std::string& out) const;
+
+    AeroDatabase(const LookupTable& table, unsigned axis_mask, bool from_cache);
+
+private:
+    enum { AXIS_M = 1, AXIS_ALPHA = 2, AXIS_H = 4 };
+
+    LookupTable table;
+    unsigned axis_mask;
+    bool from_cache;
+};
+
+#endif
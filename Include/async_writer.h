@@ -0,0 +1,70 @@
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "bounded_queue.h"
+
+/*
+ * Фоновый вывод результатов: расчётный поток ставит задания вывода
+ * (таблица, файлы траектории) и сразу продолжает расчёт.
+ *
+ * Задания передаются через ограниченную очередь без блокировок
+ * (bounded_queue.h) и выполняются потоком записи строго в порядке
+ * постановки. Консольный вывод заданий идёт в общий поток out, который
+ * сохраняет состояние форматирования между заданиями, поэтому вывод
+ * совпадает с последовательным выводом в target побайтно.
+ *
+ * Поток out записывает в один из двух буферов; заполненный буфер отдаётся
+ * третьему потоку, который пишет его в target, пока заполняется второй.
+ *
+ * Обратное давление: при заполненной очереди submit ждёт, поэтому в памяти
+ * не больше queue_capacity невыведенных заданий (траекторий) и двух буферов.
+ */
+class AsyncWriter {
+public:
+    typedef std::function<void(std::ostream& out)> Job;
+
+    explicit AsyncWriter(std::ostream& target = std::cout, size_t queue_capacity = 4,
+                         size_t buffer_bytes = 64 * 1024);
+    // Выполняет оставшиеся задания и выводит буферы
+    ~AsyncWriter();
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    // Исключения задания перехватываются потоком записи (сообщение в std::cerr)
+    void submit(Job job);
+
+    // Ожидание выполнения поставленных заданий и вывода в target
+    void flush();
+
+    // Число ожиданий свободного места в очереди (срабатываний обратного давления)
+    unsigned long long stalls() const { return stall_count.load(); }
+
+private:
+    class OutputBuffer;
+
+    void writerLoop();
+
+    BoundedQueue<Job> queue;
+    std::unique_ptr<OutputBuffer> buffer;
+    std::ostream out;
+
+    std::mutex mutex;
+    std::condition_variable job_ready;   // поток записи ждёт задание
+    std::condition_variable job_taken;   // производители ждут места, flush - выполнения
+    std::atomic<bool> writer_sleeping{false};
+    std::atomic<unsigned long long> submitted{0};
+    std::atomic<unsigned long long> completed{0};
+    std::atomic<unsigned long long> stall_count{0};
+    bool stopping = false;
+    std::thread writer;
+};
+
+#endif
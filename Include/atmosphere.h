@@ -22,6 +22,29 @@ typedef struct {
  */
 AtmosphereParams calculate_atmosphere(double altitude);
 
+/* Курсор слоя атмосферы для последовательных запросов на близких высотах */
+typedef struct {
+    int layer;      /* слой предыдущего запроса; 0 - начальное значение */
+} AtmosphereCursor;
+
+/**
+ * То же, что calculate_atmosphere, но поиск слоя начинается со слоя
+ * предыдущего запроса и проверяет сначала соседние слои.
+ * Результат совпадает с calculate_atmosphere(altitude).
+ * @param cursor - курсор, обновляется найденным слоем
+ * @throws std::invalid_argument если высота вне допустимого диапазона
+ */
+AtmosphereParams calculate_atmosphere_cursor(double altitude, AtmosphereCursor* cursor);
+
+/**
+ * Быстрый вариант calculate_atmosphere_cursor (режим быстрой физики):
+ * давление - exp от константы слоя, вычисленной заранее, вместо log10 и pow
+ * (в изотермическом слое без логарифма). Относительная погрешность p и ro
+ * не более 1e-13, остальные поля совпадают с calculate_atmosphere побитово.
+ * @throws std::invalid_argument если высота вне допустимого диапазона
+ */
+AtmosphereParams calculate_atmosphere_fast(double altitude, AtmosphereCursor* cursor);
+
 #ifdef __cplusplus
 }
 #endif
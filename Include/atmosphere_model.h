@@ -0,0 +1,96 @@
+#ifndef ATMOSPHERE_MODEL_H
+#define ATMOSPHERE_MODEL_H
+
+#include <cmath>
+
+/*
+ * Формулы и слои стандартной атмосферы - общие для calculate_atmosphere
+ * (atmosphere.cpp) и пакетных ядер (kernels.h), чтобы пакетный расчёт
+ * совпадал с поточечным побитово.
+ */
+namespace atmosphere_model {
+
+const double R = 287.05287;        // Газовая постоянная для воздуха, Дж/(кг·К)
+const double G0 = 9.80665;         // Ускорение свободного падения на уровне моря, м/с²
+const double T0 = 288.15;          // Температура на уровне моря, К
+const double P0 = 101325.0;        // Давление на уровне моря, Па
+const double R_EARTH = 6356767.0;  // Радиус Земли, м
+
+// Допустимый диапазон геометрических высот, м
+const double H_MIN = -2000.0;
+const double H_MAX = 94000.0;
+
+// Слой: T = T_base + beta * (H - H_base), H - геопотенциальная высота
+struct Layer {
+    double bottom;      // нижняя геометрическая граница (опорная высота), м
+    double top;         // верхняя геометрическая граница, м
+    double T_base;      // опорная температура, К
+    double beta;        // температурный градиент, К/м
+    double P_base;      // опорное давление, Па
+};
+
+const int LAYER_COUNT = 8;
+
+// Слои в порядке возрастания высоты: тропосфера, стратосфера (3), мезосфера (3), термосфера
+const Layer LAYERS[LAYER_COUNT] = {
+    {0.0,     11000.0, T0,     -0.0065, P0},
+    {11000.0, 20000.0, 216.65,  0.0,    22632.0},
+    {20000.0, 32000.0, 216.65,  0.0010, 5474.9},
+    {32000.0, 47000.0, 228.65,  0.0028, 868.02},
+    {47000.0, 51000.0, 270.65,  0.0,    110.91},
+    {51000.0, 71000.0, 270.65, -0.0028, 66.939},
+    {71000.0, 85000.0, 214.65, -0.0020, 3.9564},
+    {85000.0, 94000.0, 186.65,  0.0,    0.3734}
+};
+
+inline bool isothermal(const Layer& layer) {
+    return std::abs(layer.beta) < 1e-10;
+}
+
+// Геопотенциальная высота: H = (R * h) / (R + h)
+inline double geopotential_height(double geometric_height) {
+    return (R_EARTH * geometric_height) / (R_EARTH + geometric_height);
+}
+
+// Ускорение свободного падения: g = g0 * (R/(R+h))^2
+inline double gravity(double geometric_height) {
+    double ratio = R_EARTH / (R_EARTH + geometric_height);
+    return G0 * ratio * ratio;
+}
+
+// Температура в слое; H_base_geo = geopotential_height(layer.bottom)
+inline double temperature(const Layer& layer, double H_geo, double H_base_geo) {
+    if (isothermal(layer)) return layer.T_base;
+    return layer.T_base + layer.beta * (H_geo - H_base_geo);
+}
+
+// Показатель степени lg(p/p_base)
+inline double pressure_exponent(const Layer& layer, double H_geo, double H_base_geo) {
+    if (isothermal(layer)) {
+        // При beta = 0: lg(p) = lg(p_base) - (0.434294 * g0 * (H - H_base)) / (R * T_base)
+        double delta_H = H_geo - H_base_geo;
+        return - (0.434294 * G0 * delta_H) / (R * layer.T_base);
+    }
+    // При beta ≠ 0: lg(p) = lg(p_base) - g0/(beta*R) * lg((T_base + beta*(H-H_base))/T_base)
+    double T_current = layer.T_base + layer.beta * (H_geo - H_base_geo);
+    double lg_ratio = std::log10(T_current / layer.T_base);
+    return - (G0 / (layer.beta * R)) * lg_ratio;
+}
+
+inline double pressure(const Layer& layer, double H_geo, double H_base_geo) {
+    return layer.P_base * std::pow(10.0, pressure_exponent(layer, H_geo, H_base_geo));
+}
+
+// Скорость звука: a = 20.046796 * sqrt(T)
+inline double sound_speed(double temperature) {
+    return 20.046796 * std::sqrt(temperature);
+}
+
+// Плотность воздуха: ro = p / (R * T)
+inline double density(double pressure, double temperature) {
+    return pressure / (R * temperature);
+}
+
+} // namespace atmosphere_model
+
+#endif
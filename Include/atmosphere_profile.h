@@ -0,0 +1,66 @@
+#ifndef ATMOSPHERE_PROFILE_H
+#define ATMOSPHERE_PROFILE_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include "atmosphere.h"
+
+/*
+ * Атмосфера по измеренному профилю (зондированию).
+ *
+ * Файл профиля - текст, по уровню в строке (строки с '#' пропускаются):
+ *   H(м)  T(К)  p(Па)  [w(м/с)]
+ * Высоты строго возрастают; w - горизонтальный ветер вдоль оси x
+ * (положительный - попутный). Внутри слоя между уровнями T и w линейны
+ * по высоте, ln(p) линеен по высоте, поэтому значения на уровнях точные.
+ * Коэффициенты слоёв рассчитываются при загрузке, слой находится через
+ * равномерный индекс: ширина корзины - по самому тонкому слою (число корзин
+ * ограничено), внутри корзины - двоичный поиск, поэтому и густые у земли
+ * зондирования ищутся за O(1)..O(log n). Вне диапазона профиля используется
+ * стандартная атмосфера (calculate_atmosphere) без ветра.
+ */
+class AtmosphereProfile {
+public:
+    AtmosphereProfile(const std::vector<double>& altitude, const std::vector<double>& T,
+                      const std::vector<double>& p, const std::vector<double>& wind);
+
+    /**
+     * @throws std::runtime_error если файл не открыт или данные некорректны
+     */
+    static std::shared_ptr<const AtmosphereProfile> load(const std::string& filename);
+
+    /**
+     * @param altitude - геометрическая высота, м
+     * @param wind - если не nullptr, сюда записывается ветер, м/с
+     * @throws std::invalid_argument вне диапазона стандартной атмосферы
+     */
+    AtmosphereParams evaluate(double altitude, double* wind = nullptr) const;
+
+    double minAltitude() const { return levels_min; }
+    double maxAltitude() const { return levels_max; }
+    size_t levelCount() const { return segments.size() + 1; }
+    bool hasWind() const { return has_wind; }
+
+    // Дописывает в out байты, однозначно задающие профиль (для ключей кэша результатов)
+    void appendContent(std::string& out) const;
+
+private:
+    // Слой [h0, h0 + dh]: T = T0 + dT*(h - h0), ln p = lnp0 + dlnp*(h - h0), w = w0 + dw*(h - h0)
+    struct Segment {
+        double h0;
+        double T0, dT;
+        double lnp0, dlnp;
+        double w0, dw;
+    };
+
+    size_t findSegment(double altitude) const;
+
+    std::vector<Segment> segments;
+    std::vector<unsigned> bucket_segment;  // слой, содержащий начало корзины; последний элемент - последний слой
+    double bucket_inv_width = 0.0;
+    double levels_min = 0.0, levels_max = 0.0;
+    bool has_wind = false;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <memory>
+#include "trajectory.h"
+#include "atmosphere_profile.h"
+#include "aero_database.h"
+
+class ResultCache;
+
+// Один случай пакетного расчёта
+struct BatchCase {
+    std::string name;
+    VehicleParams params;
+    IntegrationMethod method;
+    AlphaLaw alpha_law;
+    double dt;
+};
+
+struct BatchOptions {
+    unsigned threads = 0;                        // 0 - по числу ядер
+    std::string checkpoint_file;                 // пусто - без контрольных точек
+    double checkpoint_period = 60.0;             // период записи контрольной точки, с
+    unsigned long long snapshot_interval = 1000; // шагов между проверками запроса снимка
+    std::shared_ptr<const AtmosphereProfile> atmosphere;  // nullptr - стандартная атмосфера
+    std::shared_ptr<const AeroDatabase> aero;             // nullptr - встроенные таблицы
+    PitchDynamics pitch;                                  // по умолчанию выключена
+    bool fast_math = false;                               // быстрая физика (fast_math.h)
+    std::shared_ptr<ResultCache> cache;                   // кэш результатов (result_cache.h) или nullptr
+    bool end_state_only = false;   // on_complete нужно только конечное состояние (back())
+};
+
+// Вызывается из рабочих потоков параллельно; worker - номер потока [0, threads)
+typedef std::function<void(unsigned worker, size_t index,
+                           const std::vector<TrajectoryPoint>& trajectory)> BatchCallback;
+
+// Имена методов и законов в текстовом формате случаев
+const char* methodName(IntegrationMethod method);
+const char* alphaLawName(AlphaLaw alpha_law);
+bool parseMethod(const std::string& name, IntegrationMethod& method);
+bool parseAlphaLaw(const std::string& name, AlphaLaw& alpha_law);
+
+// Поля VehicleParams по номерам (в порядке структуры) и именам
+const size_t VEHICLE_FIELD_COUNT = 12;
+const char* vehicleFieldName(size_t index);
+size_t vehicleFieldIndex(const std::string& name);   // VEHICLE_FIELD_COUNT - нет такого поля
+double& vehicleField(VehicleParams& params, size_t index);
+double vehicleField(const VehicleParams& params, size_t index);
+
+/**
+ * Строка случая (поля через пробел):
+ *   name V0 theta_c0 m_dot W y0 omega_z0 theta0 t_end m0 I_d S_a S_m method alpha_law dt
+ * method: EULER | MODIFIED_EULER | RUNGE_KUTTA_4 | ROSENBROCK, alpha_law: THETA | ZERO
+ */
+bool parseBatchCase(const std::string& line, BatchCase& result);
+std::string formatBatchCase(const BatchCase& batch_case);
+
+/**
+ * Загрузка списка случаев; пустые строки и строки с '#' пропускаются
+ * @throws std::runtime_error если файл не открыт или строка не разобрана
+ */
+std::vector<BatchCase> loadBatchCases(const std::string& filename);
+
+// Отпечаток списка случаев (для проверки соответствия контрольной точки)
+unsigned long long batchFingerprint(const std::vector<BatchCase>& cases);
+
+// Отпечаток модели пакета: содержимое профиля атмосферы и аэродинамической базы,
+// динамика тангажа и режим физики (threads, контрольные точки и кэш не входят)
+unsigned long long batchOptionsFingerprint(const BatchOptions& options);
+
+/**
+ * Параллельный расчёт пакета. При заданном checkpoint_file состояние пакета
+ * (завершённые случаи и снимки незавершённых) периодически записывается на диск,
+ * а при повторном запуске с тем же списком расчёт продолжается с контрольной точки:
+ * завершённые случаи пропускаются, прерванные продолжаются с сохранённого шага.
+ * После успешного завершения файл контрольной точки удаляется.
+ * С кэшем результатов случаи, найденные в кэше, не рассчитываются, а
+ * рассчитанные записываются в кэш. Траектория из кэша совпадает с рассчитанной;
+ * только при end_state_only это может быть одна точка конечного состояния.
+ * @return Число случаев, рассчитанных в этом запуске (без взятых из кэша)
+ */
+size_t runBatch(const std::vector<BatchCase>& cases, const BatchOptions& options,
+                const BatchCallback& on_complete);
+
+#endif
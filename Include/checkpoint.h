@@ -0,0 +1,37 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "trajectory.h"
+
+// Незавершённый случай пакета: состояние интегратора и уже полученные точки
+struct CaseSnapshot {
+    size_t index;
+    IntegratorState state;
+    std::vector<TrajectoryPoint> trajectory;
+};
+
+// Контрольная точка пакетного расчёта
+struct BatchCheckpoint {
+    unsigned long long fingerprint;      // отпечаток списка случаев
+    std::vector<unsigned char> done;     // 1 - случай завершён
+    std::vector<CaseSnapshot> running;   // прерванные случаи
+};
+
+// Двоичная запись состояния интегратора (порядок байт платформы)
+void writeIntegratorState(std::ostream& out, const IntegratorState& state);
+bool readIntegratorState(std::istream& in, IntegratorState& state);
+
+/**
+ * Запись контрольной точки: сначала во временный файл, затем переименование,
+ * поэтому прерывание во время записи не портит предыдущую контрольную точку.
+ * @return false при ошибке записи
+ */
+bool saveBatchCheckpoint(const std::string& filename, const BatchCheckpoint& checkpoint);
+
+// @return false, если файла нет или он повреждён
+bool loadBatchCheckpoint(const std::string& filename, BatchCheckpoint& checkpoint);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef DOWNSAMPLING_H
+#define DOWNSAMPLING_H
+
+#include <vector>
+#include <cstddef>
+#include "trajectory.h"
+
+// Допустимые отклонения при прореживании траектории
+struct DownsampleTolerance {
+    double x;   // по дальности, м
+    double y;   // по высоте, м
+    double V;   // по скорости, м/с
+};
+
+/**
+ * Прореживание траектории по Дугласу–Пекеру раздельно для каналов x, y, V.
+ * Точка сохраняется, если хотя бы в одном канале линейная интерполяция по
+ * оставленным соседям (по времени t) отклоняется больше допуска.
+ * Первая и последняя точки сохраняются всегда.
+ * @param points - точки траектории, упорядоченные по времени
+ * @param tolerance - допуски по каналам (0 - канал восстанавливается точно)
+ * @return Возрастающие индексы сохраняемых точек
+ */
+std::vector<size_t> downsampleIndices(const std::vector<const TrajectoryPoint*>& points,
+                                      const DownsampleTolerance& tolerance);
+
+// Линейное восстановление всех полей точки по прореженной траектории
+TrajectoryPoint interpolateTrajectory(const std::vector<TrajectoryPoint>& reduced, double t);
+
+#endif
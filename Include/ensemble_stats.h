@@ -0,0 +1,193 @@
+#ifndef ENSEMBLE_STATS_H
+#define ENSEMBLE_STATS_H
+
+#include <cstdint>
+#include <ostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "trajectory.h"
+
+/*
+ * Потоковая статистика ансамбля траекторий для исследований разброса.
+ *
+ * Траектория не хранится: конечное состояние и состояния в заданные моменты
+ * времени сразу добавляются в накопители. Каждый рабочий поток ведёт свой
+ * EnsembleStats, в конце они объединяются merge. Объём памяти не зависит от
+ * числа траекторий, а результат - от распределения траекторий по потокам и
+ * порядка объединения: все накопители складываются точно.
+ *   - Среднее и ковариация - по точным суммам значений и попарных произведений
+ *     (ExactSum), итог округляется один раз при выводе. Это та же величина,
+ *     что даёт алгоритм Уэлфорда, но без погрешности, зависящей от порядка.
+ *   - Квантили - скетч DDSketch (Masson и др., 2019): логарифмические корзины,
+ *     погрешность значения не больше relative_accuracy от его модуля. Для
+ *     величин с большим смещением (y, m, theta_c) разброс мал по сравнению с
+ *     модулем, поэтому точность по умолчанию мелкая; число корзин растёт как
+ *     log(max/min) / relative_accuracy и не больше числа значений.
+ *   - Гистограммы - фиксированные интервалы, отдельно значения ниже, выше и NaN.
+ */
+
+/**
+ * Точная сумма чисел double: целое с фиксированной точкой на весь диапазон
+ * double (младший разряд 2^-1088). Сложение и объединение точны, поэтому
+ * результат не зависит от порядка.
+ */
+class ExactSum {
+public:
+    ExactSum();
+
+    void add(double value);
+    // Точное произведение a * b (без переполнения и потери значимости)
+    void addProduct(double a, double b);
+    void merge(const ExactSum& other);
+
+    // Значение, округлённое до double; NaN, если добавлялись бесконечность или NaN
+    double value() const;
+    bool finite() const { return !non_finite; }
+
+    /**
+     * Модуль точного значения в единицах младшего разряда 2^BASE_EXPONENT
+     * (по 32 бита от младших, без старших нулей)
+     * @return true, если значение отрицательно
+     */
+    bool magnitude(std::vector<std::uint32_t>& result) const;
+
+    // Разряды по 32 бита от младшего; старший со знаком
+    static const int LIMBS = 70;
+    static const int BASE_EXPONENT = -1088;
+
+private:
+    void normalize();
+
+    std::int64_t limbs[LIMBS];
+    std::uint32_t pending;   // сложений без переноса
+    bool non_finite;
+};
+
+// Среднее и ковариация набора величин
+class EnsembleMoments {
+public:
+    explicit EnsembleMoments(size_t dims = 0);
+
+    void add(const double* values);
+    void merge(const EnsembleMoments& other);
+
+    std::uint64_t count() const { return n; }
+    size_t dims() const { return dim_count; }
+    double mean(size_t i) const;
+    // Несмещённая оценка (деление на n - 1); NaN при n < 2
+    double covariance(size_t i, size_t j) const;
+
+private:
+    size_t dim_count;
+    std::uint64_t n;
+    std::vector<ExactSum> sums;       // по величинам
+    std::vector<ExactSum> products;   // верхний треугольник, i <= j
+};
+
+/**
+ * Квантили DDSketch: значение x > 0 попадает в корзину ceil(log_gamma(x)),
+ * gamma = (1 + a) / (1 - a). Оценка квантиля - середина корзины
+ * в смысле относительной погрешности, ограниченная минимумом и максимумом.
+ */
+class QuantileSketch {
+public:
+    explicit QuantileSketch(double relative_accuracy = 1e-5);
+
+    void add(double value);
+    // @throws std::invalid_argument при разной точности скетчей
+    void merge(const QuantileSketch& other);
+
+    std::uint64_t count() const { return total; }
+    double min() const { return minimum; }
+    double max() const { return maximum; }
+    // q в [0, 1]; NaN, если значений нет
+    double quantile(double q) const;
+
+private:
+    int bucket(double magnitude) const;
+    double bucketValue(int index) const;
+
+    double accuracy;
+    double gamma;
+    double log_gamma;
+    std::map<int, std::uint64_t> positive;
+    std::map<int, std::uint64_t> negative;   // по модулю
+    std::uint64_t zeros;
+    std::uint64_t nans;
+    std::uint64_t total;
+    double minimum;
+    double maximum;
+};
+
+struct HistogramSpec {
+    std::string variable;   // имя величины (ensembleVariableName)
+    double low;
+    double high;
+    size_t bins;
+};
+
+class Histogram {
+public:
+    Histogram() : low(0.0), high(1.0), below(0), above(0), nans(0) {}
+    Histogram(double low, double high, size_t bins);
+
+    void add(double value);
+    // @throws std::invalid_argument при разных интервалах
+    void merge(const Histogram& other);
+
+    double low;
+    double high;
+    std::vector<std::uint64_t> counts;
+    std::uint64_t below;
+    std::uint64_t above;
+    std::uint64_t nans;
+};
+
+// Величины статистики: t, V, theta_c, x, y, omega_z, theta, m
+const size_t ENSEMBLE_VARIABLE_COUNT = 8;
+const char* ensembleVariableName(size_t index);
+size_t ensembleVariableIndex(const std::string& name);   // ENSEMBLE_VARIABLE_COUNT - нет такой
+
+struct EnsembleStatsOptions {
+    std::vector<double> times;              // моменты времени, кроме конечного состояния
+    double relative_accuracy = 1e-5;       // квантилей, от модуля значения
+    std::vector<HistogramSpec> histograms;  // для каждого момента и конечного состояния
+    std::vector<double> quantiles = {0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99};
+};
+
+class EnsembleStats {
+public:
+    // @throws std::invalid_argument при неизвестной величине гистограммы или неверных интервалах
+    explicit EnsembleStats(const EnsembleStatsOptions& options);
+
+    // Траектория одного расчёта; пустая считается неудачной
+    void add(const std::vector<TrajectoryPoint>& trajectory);
+    // @throws std::invalid_argument при других параметрах статистики
+    void merge(const EnsembleStats& other);
+
+    std::uint64_t runs() const { return run_count; }
+    std::uint64_t failedRuns() const { return failed; }
+
+    // Текстовый отчёт; одинаковый при любом числе потоков
+    void write(std::ostream& out) const;
+
+private:
+    // Статистика одного момента (или конечного состояния)
+    struct Section {
+        std::uint64_t missing = 0;   // траектория закончилась раньше
+        EnsembleMoments moments;
+        std::vector<QuantileSketch> sketches;
+        std::vector<Histogram> histograms;
+    };
+
+    void addState(Section& section, const TrajectoryPoint& point);
+
+    EnsembleStatsOptions options;
+    std::vector<size_t> histogram_variables;
+    std::vector<Section> sections;   // times..., затем конечное состояние
+    std::uint64_t run_count;
+    std::uint64_t failed;
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <iosfwd>
+
+/*
+ * Режим быстрой физики (TrajectoryCalculator::setFastMath).
+ *
+ * Давление стандартной атмосферы считается в натуральных логарифмах с
+ * константами слоёв, вычисленными заранее (calculate_atmosphere_fast):
+ *   градиентный слой     p = P_base * exp(k * ln(T / T_base)),  k = -g0 / (beta * R)
+ *   изотермический слой  p = P_base * exp(k * (H - H_base)),    k = -ln10 * 0.434294 * g0 / (R * T_base)
+ * вместо pow(10, lg(...)) - один exp (и один log) вместо log10 и pow.
+ *
+ * Допуски (проверяет fastMathSelfTest):
+ *   p и ro стандартной атмосферы - относительная погрешность не более 1e-13;
+ *   T, a, g - совпадают с точным расчётом побитово;
+ *   траектория - |быстрая - точная| / max(1, |точная|) по V, theta_c, x, y не более 1e-10.
+ */
+
+/**
+ * Сравнение быстрой физики с точной: атмосфера на случайных высотах и
+ * границах слоёв, две траектории; в out - погрешности, допуски и время
+ * @return true, если все погрешности в пределах допусков
+ */
+bool fastMathSelfTest(std::ostream& out);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstddef>
+
+/*
+ * Пакетные вычислительные ядра в нескольких вариантах набора команд x86-64
+ * (generic, sse4.2, avx2, avx512).
+ *
+ * Варианты собираются из одного исходного текста (kernels_impl.h) с разными
+ * флагами -m... и -ffp-contract=off: компилятор векторизует циклы, но не
+ * объединяет умножение и сложение и не меняет порядок операций, поэтому все
+ * варианты дают одинаковый результат, совпадающий с поточечным расчётом.
+ * При запуске выбирается лучший вариант, поддерживаемый процессором
+ * (__builtin_cpu_supports); выбор можно переопределить (selectKernels).
+ *
+ * Ограничение: интегрирование траектории считает атмосферу и аэродинамику
+ * поточечно на каждом шаге и ядра не использует. Ядра работают только при
+ * пересчёте производных столбцов готовой траектории (TrajectoryTable::derive
+ * в режиме --columns, стандартная атмосфера и табличная аэродинамика) и
+ * в --isa-selftest.
+ */
+
+// Столбцы результата пакетного расчёта атмосферы; nullptr - величина не нужна
+struct AtmosphereColumns {
+    double* T = nullptr;
+    double* p = nullptr;    // давление и плотность требуют pow/log10 - самые дорогие
+    double* ro = nullptr;
+    double* a = nullptr;
+    double* g = nullptr;
+};
+
+struct KernelSet {
+    const char* name;
+
+    /**
+     * Стандартная атмосфера для count высот, как calculate_atmosphere.
+     * Вне диапазона [-2000, 94000] м результат - NaN (без исключений).
+     */
+    void (*atmosphere)(const double* altitude, size_t count, const AtmosphereColumns& out);
+
+    /**
+     * Линейная интерполяция таблицы (xs, ys) из nodes >= 2 узлов в count точках,
+     * как interpolate_linear: вне таблицы - крайние значения, NaN - последнее значение
+     */
+    void (*interpolate)(const double* xs, const double* ys, size_t nodes,
+                        const double* x, size_t count, double* out);
+};
+
+// Выбранный вариант (при первом вызове - лучший поддерживаемый)
+const KernelSet& kernels();
+
+// Варианты, поддерживаемые процессором, от базового к лучшему
+std::vector<const KernelSet*> availableKernels();
+
+/**
+ * Выбор варианта по имени
+ * @return false, если вариант неизвестен или не поддерживается процессором
+ */
+bool selectKernels(const std::string& name);
+
+/**
+ * Сравнение всех доступных вариантов с generic, а generic - с поточечным
+ * расчётом (calculate_atmosphere, interpolate_linear) на случайных и граничных
+ * данных; в out - результат и время вариантов
+ * @return true, если все результаты совпадают побитово
+ */
+bool kernelSelfTest(std::ostream& out);
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef LOOKUP_TABLE_H
+#define LOOKUP_TABLE_H
+
+#include <vector>
+#include <string>
+#include <array>
+#include <memory>
+#include <cstdint>
+
+/*
+ * Многомерная таблица на прямоугольной сетке с несколькими величинами в узле.
+ *
+ * Значения хранятся построчно (последняя ось меняется быстрее всего),
+ * величины узла подряд: values[index * components + c], где
+ * index = sum(i_d * stride_d). Шаги по осям рассчитываются один раз.
+ * Вне сетки значения берутся с границы (как interpolate_linear).
+ *
+ * Таблица может ссылаться на отображённый в память двоичный файл
+ * (mapBinary): тогда загрузка не зависит от размера таблицы.
+ */
+class LookupTable {
+public:
+    static const size_t MAX_DIMS = 8;
+
+    // Пользовательские данные двоичного файла (например, отпечаток источника)
+    typedef std::array<std::uint64_t, 4> Meta;
+
+    LookupTable() = default;
+
+    /**
+     * @param axes - узлы по осям, строго возрастают
+     * @param values - axes[0].size() * ... * components значений
+     * @throws std::runtime_error при несогласованных размерах
+     */
+    LookupTable(const std::vector<std::vector<double>>& axes, size_t components,
+                const std::vector<double>& values);
+
+    size_t dims() const { return dim_count; }
+    size_t components() const { return component_count; }
+    size_t axisSize(size_t d) const { return axis_len[d]; }
+    const double* axis(size_t d) const { return axis_ptr[d]; }
+    size_t stride(size_t d) const { return strides[d]; }   // в узлах
+    const double* values() const { return data; }          // nodeCount() * components() значений
+    size_t nodeCount() const;
+    bool empty() const { return dim_count == 0; }
+
+    /**
+     * Полилинейная интерполяция.
+     * @param x - координаты, dims() значений
+     * @param out - результат, components() значений
+     * @param intervals - курсоры интервалов по осям (dims() значений) или nullptr;
+     *                    поиск начинается с них, результат от них не зависит
+     */
+    void interpolate(const double* x, double* out, size_t* intervals = nullptr) const;
+
+    /**
+     * Запись в двоичный файл (через временный файл и переименование)
+     * @return false при ошибке записи
+     */
+    bool saveBinary(const std::string& filename, const Meta& meta) const;
+
+    /**
+     * Отображение двоичного файла в память (без отображения - чтение целиком)
+     * @return false, если файла нет, он повреждён или записан на другой платформе
+     */
+    static bool mapBinary(const std::string& filename, LookupTable& table, Meta& meta);
+
+private:
+    void setup(size_t dims, const std::uint64_t* lengths, const double* axes_begin, size_t components);
+
+    size_t dim_count = 0;
+    size_t component_count = 0;
+    std::array<const double*, MAX_DIMS> axis_ptr{};
+    std::array<size_t, MAX_DIMS> axis_len{};
+    std::array<size_t, MAX_DIMS> strides{};   // в узлах
+    const double* data = nullptr;
+
+    // Владелец памяти осей и значений (вектор или отображение файла)
+    std::shared_ptr<const void> storage;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef PARAREAL_H
+#define PARAREAL_H
+
+#include <vector>
+#include "trajectory.h"
+
+/*
+ * Параллельный по времени расчёт одной траектории (Parareal).
+ *
+ * Интервал [0, t_end] делится на отрезки по шагам точного метода.
+ * Грубый пропагатор G (Эйлер с крупным шагом) идёт последовательно,
+ * точные решения F на отрезках выполняются параллельно, состояния на
+ * границах уточняются итерациями
+ *   U[n+1] = F(U_old[n]) + (G(U[n]) - G(U_old[n]))
+ * до тех пор, пока их относительное изменение не станет меньше tolerance.
+ * После k итераций первые k отрезков совпадают с последовательным расчётом
+ * побитово, поэтому при max_iterations = slices результат точный.
+ */
+struct PararealOptions {
+    unsigned slices = 0;          // число отрезков; 0 - по числу потоков
+    unsigned threads = 0;         // 0 - по числу ядер
+    double coarse_dt = 0.1;       // шаг грубого пропагатора, с
+    double tolerance = 1e-10;     // порог относительного изменения состояний на границах
+    unsigned max_iterations = 0;  // 0 - не более slices
+};
+
+struct PararealReport {
+    unsigned slices = 0;
+    unsigned iterations = 0;
+    bool converged = false;
+    double max_change = 0.0;      // изменение на последней итерации
+    double wall_seconds = 0.0;    // время расчёта
+    double serial_seconds = 0.0;  // оценка последовательного расчёта: сумма F первой итерации
+    double speedup = 0.0;         // serial_seconds / wall_seconds
+};
+
+/**
+ * Расчёт траектории методом fine_method с шагом dt.
+ * @param trajectory - результат (очищается)
+ * @return false при ошибке расчёта (сообщение в std::cerr)
+ */
+bool calculateTrajectoryParareal(const TrajectoryCalculator& calculator, IntegrationMethod fine_method,
+                                 AlphaLaw alpha_law, double dt, const PararealOptions& options,
+                                 std::vector<TrajectoryPoint>& trajectory, PararealReport* report = nullptr);
+
+#endif
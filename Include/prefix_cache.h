@@ -0,0 +1,93 @@
+#ifndef PREFIX_CACHE_H
+#define PREFIX_CACHE_H
+
+#include <vector>
+#include <memory>
+#include <string>
+#include "trajectory.h"
+
+/*
+ * Кэш префиксов траектории для серии расчётов "что если".
+ *
+ * Во время расчёта через каждые snapshot_interval шагов запоминается снимок
+ * (состояние интегратора и число точек до него). Снимки привязаны к входным
+ * данным, от которых зависит начало траектории: параметрам ЛА кроме t_end,
+ * методу, закону угла атаки, шагу, моделям атмосферы и аэродинамики,
+ * динамике тангажа и режиму физики. Следующий расчёт с теми же данными
+ * продолжается с последнего снимка, который ещё верен, и даёт те же точки,
+ * что полный расчёт calculateTrajectory:
+ *   - изменился только t_end - верны снимки до нового t_end;
+ *   - модель аэродинамики или атмосферы изменилась только выше некоторого
+ *     числа Маха или высоты (aeroChangedFrom, atmosphereChangedFrom) - верны
+ *     снимки, до которых траектория эти значения не достигала
+ *     (FlightEnvelope - по всем стадиям шагов, не только по точкам);
+ *   - любое другое изменение - расчёт с начала.
+ * Кэш хранит точки последнего расчёта; один кэш - один поток.
+ */
+class TrajectoryPrefixCache {
+public:
+    explicit TrajectoryPrefixCache(unsigned long long snapshot_interval = 1000);
+
+    /**
+     * То же, что calculator.calculateTrajectory(method, alpha_law, dt, trajectory),
+     * с продолжением от верного снимка предыдущих расчётов
+     * @param error - куда записать сообщение об ошибке (nullptr - в std::cerr)
+     * @return false при ошибке (буфер пуст, кэш очищен)
+     */
+    bool calculate(const TrajectoryCalculator& calculator, IntegrationMethod method,
+                   AlphaLaw alpha_law, double dt, std::vector<TrajectoryPoint>& trajectory,
+                   std::string* error = nullptr);
+
+    /**
+     * Аэродинамика (база калькулятора или встроенные таблицы) меняется только при M >= mach:
+     * снимки, где M достигало mach, отбрасываются; следующий расчёт может быть с другой
+     * базой (setAeroDatabase), совпадающей с прежней ниже mach
+     */
+    void aeroChangedFrom(double mach);
+
+    // То же для атмосферы, меняющейся только на высотах >= altitude (setAtmosphereProfile)
+    void atmosphereChangedFrom(double altitude);
+
+    void clear();
+
+    struct Stats {
+        unsigned long long runs = 0;
+        unsigned long long resumed = 0;          // расчётов, продолженных со снимка
+        unsigned long long reused_steps = 0;     // шагов, взятых из снимков
+        unsigned long long computed_steps = 0;   // шагов, рассчитанных заново
+    };
+    const Stats& stats() const { return counters; }
+
+private:
+    // Входные данные, от которых зависит начало траектории (без t_end)
+    struct Key {
+        VehicleParams params;   // t_end = 0
+        IntegrationMethod method;
+        AlphaLaw alpha_law;
+        double dt;
+        std::shared_ptr<const AtmosphereProfile> atmosphere;
+        std::shared_ptr<const AeroDatabase> aero;
+        PitchDynamics pitch;
+        bool fast_math;
+    };
+
+    struct Snapshot {
+        IntegratorState state;
+        size_t points;          // точек траектории до снимка включительно
+    };
+
+    static Key makeKey(const TrajectoryCalculator& calculator, IntegrationMethod method,
+                       AlphaLaw alpha_law, double dt);
+    bool sameInputs(const Key& key) const;
+
+    unsigned long long snapshot_interval;
+    bool has_key = false;
+    Key key;
+    bool aero_rebind = false;         // после aeroChangedFrom база может смениться
+    bool atmosphere_rebind = false;
+    std::vector<Snapshot> snapshots;  // по возрастанию шагов
+    std::vector<TrajectoryPoint> points;
+    Stats counters;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef REALTIME_STEPPER_H
+#define REALTIME_STEPPER_H
+
+#include <ostream>
+#include "trajectory.h"
+
+/*
+ * Пошаговый расчёт с фиксированной частотой для полунатурного моделирования
+ * и связи с тренажёром: один вызов step(dt) - один такт управления.
+ *
+ * Шаг и чтение состояния не выделяют память, не бросают исключений и не
+ * выполняют ввода-вывода: калькулятор копируется при создании, курсоры поиска
+ * хранятся в объекте, вне области модели атмосферы используются значения по
+ * умолчанию, как в calculateTrajectory. Без команд шаги совпадают с шагами
+ * continueTrajectory того же метода бит в бит.
+ *
+ * Команды (ControlCommand) действуют до снятия:
+ *   commandOmegaZ - угловая скорость тангажа выдерживается идеальным приводом
+ *                   (динамика тангажа для omega_z отключается);
+ *   commandAlpha  - угол атаки задаётся вместо закона AlphaLaw.
+ * Объект не потокобезопасен: один объект - один поток управления.
+ */
+class RealtimeStepper {
+public:
+    // @throws std::invalid_argument при неизвестном методе
+    RealtimeStepper(const TrajectoryCalculator& calculator,
+                    IntegrationMethod method = RUNGE_KUTTA_4,
+                    AlphaLaw alpha_law = ALPHA_THETA_MINUS_THETAC);
+
+    // Возврат к начальному состоянию калькулятора (t = 0), команды сохраняются
+    void reset() noexcept;
+    void setState(double t, const StateVector& state) noexcept;
+
+    /**
+     * Шаг на dt секунд
+     * @return false, если dt не положителен или не конечен (состояние не меняется)
+     */
+    bool step(double dt) noexcept;
+
+    void commandOmegaZ(double omega_z) noexcept;   // град/с
+    void commandAlpha(double alpha) noexcept;      // град
+    void clearCommands() noexcept;
+    const ControlCommand& command() const noexcept { return control; }
+
+    double time() const noexcept { return t; }
+    const StateVector& state() const noexcept { return current; }
+    unsigned long long steps() const noexcept { return step_count; }
+
+    // Полная точка траектории (M, Cxa, alpha, ...) в текущем состоянии
+    TrajectoryPoint point() noexcept;
+
+    // Условие окончания расчёта calculateTrajectory: t >= t_end или m <= 0.1 m0;
+    // шаги после него возможны
+    bool finished() const noexcept;
+
+private:
+    TrajectoryCalculator calculator;
+    IntegrationMethod method;
+    AlphaLaw alpha_law;
+    ControlCommand control;
+    LookupCursors cursors;
+    double t;
+    StateVector current;
+    unsigned long long step_count;
+};
+
+struct RealtimeBenchOptions {
+    double rate = 1000.0;                 // частота тактов, Гц
+    unsigned long long steps = 200000;    // измеряемых шагов
+    IntegrationMethod method = RUNGE_KUTTA_4;
+};
+
+/**
+ * Замер задержки шага: распределение времени step (среднее, медиана, p99,
+ * p99.9, максимум), доля тактов, не уложившихся в период 1/rate, и проверка
+ * совпадения шагов с continueTrajectory. При окончании полёта расчёт
+ * начинается заново (reset). Максимум включает вытеснение потока системой;
+ * для гарантий сроков поток управления нужно закрепить за ядром с политикой
+ * реального времени (SCHED_FIFO) - это делает вызывающее приложение.
+ * @return false, если шаги не совпали с continueTrajectory
+ */
+bool realtimeBenchmark(const TrajectoryCalculator& calculator, const RealtimeBenchOptions& options,
+                       std::ostream& out);
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "batch.h"
+
+/*
+ * Кэш результатов расчёта на диске с адресацией по содержимому.
+ *
+ * Ключ - 128-битный FNV-1a от всех входных данных случая: параметров ЛА,
+ * метода, закона угла атаки, шага, содержимого профиля атмосферы и
+ * аэродинамической базы, динамики тангажа, режима физики и версии модели
+ * RESULT_MODEL_VERSION. Имя случая в ключ не входит. Запись в
+ * <directory>/<2 знака>/<ключ>.res содержит конечное состояние и, в режиме
+ * trajectories, всю траекторию. Запись без траектории отдаётся только тем,
+ * кому нужно одно конечное состояние, поэтому результат не зависит от
+ * заполненности кэша.
+ *
+ * Доступ из нескольких процессов:
+ *   - запись - во временный файл и переименование, читатель видит запись
+ *     целиком или не видит её; одинаковый ключ даёт одинаковое содержимое,
+ *     поэтому одновременная запись безопасна;
+ *   - попадание обновляет время изменения файла, вытесняются записи с самым
+ *     старым временем (LRU), пока объём не станет не больше 90% max_bytes;
+ *   - вытеснение выполняется под блокировкой flock файла <directory>/lock
+ *     (без POSIX - без блокировки). Открытый читателем файл после удаления
+ *     дочитывается.
+ */
+
+// Увеличивается при любом изменении физики, меняющем результаты
+const unsigned RESULT_MODEL_VERSION = 1;
+
+typedef std::array<std::uint64_t, 2> ResultKey;
+
+struct ResultCacheOptions {
+    std::string directory = "results/cache";
+    std::uint64_t max_bytes = 1ULL << 30;   // предел объёма записей
+    bool trajectories = true;               // false - только конечные состояния
+};
+
+class ResultCache {
+public:
+    explicit ResultCache(const ResultCacheOptions& options);
+
+    const ResultCacheOptions& options() const { return config; }
+
+    // Отпечаток модели (версия, атмосфера, аэродинамика, тангаж, режим физики) -
+    // один раз на пакет: содержимое таблиц хэшируется целиком
+    static ResultKey modelDigest(const BatchOptions& options);
+    // Ключ случая: поля случая и отпечаток модели
+    static ResultKey key(const BatchCase& batch_case, const ResultKey& model);
+    static std::string keyName(const ResultKey& key);   // 32 шестнадцатеричных знака
+
+    /**
+     * Результат по ключу: траектория целиком или, при end_state_only, одна точка
+     * конечного состояния
+     * @return false, если записи нет, она повреждена или в ней нет нужной траектории
+     */
+    bool lookup(const ResultKey& key, std::vector<TrajectoryPoint>& trajectory, bool end_state_only = false);
+
+    // Запись результата (пустая траектория не записывается); ошибки записи не критичны
+    void store(const ResultKey& key, const std::vector<TrajectoryPoint>& trajectory);
+
+    // Вытеснение старых записей до 90% max_bytes; @return число удалённых записей
+    size_t trim();
+
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t stores = 0;
+        std::uint64_t evicted = 0;
+    };
+    Stats stats() const;
+
+private:
+    std::string entryPath(const ResultKey& key) const;
+
+    ResultCacheOptions config;
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+    std::atomic<std::uint64_t> stores{0};
+    std::atomic<std::uint64_t> evicted{0};
+    std::atomic<std::uint64_t> written_since_trim{0};
+    std::atomic<std::uint64_t> temp_counter{0};
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "batch.h"
+
+/*
+ * Выборки параметров ЛА для исследований разброса.
+ *
+ * Оба генератора вычисляют точку по её номеру без состояния, поэтому
+ * части выборки (шарды) генерируются независимо пропуском начальных
+ * номеров и не пересекаются.
+ *
+ * SobolSequence - последовательность Соболя (направляющие числа Joe-Kuo)
+ * со скремблированием Оуэна через хеш (Burley, 2020); seed = 0 - без
+ * скремблирования.
+ * LatinHypercube - латинский гиперкуб размера design_size: по каждой оси
+ * номер слоя задаёт хешированная перестановка (Kensler, 2013), положение
+ * внутри слоя - хеш номера точки.
+ */
+class SobolSequence {
+public:
+    static const unsigned MAX_DIMS = 21;
+
+    // @throws std::invalid_argument при dims = 0 или dims > MAX_DIMS
+    SobolSequence(unsigned dims, std::uint32_t seed);
+
+    // Точка с номером index, значения в (0, 1)
+    void sample(std::uint64_t index, double* out) const;
+
+    unsigned dims() const { return dim_count; }
+
+private:
+    unsigned dim_count;
+    std::uint32_t seed;
+    std::vector<std::uint32_t> directions;   // 32 направляющих числа на ось
+};
+
+class LatinHypercube {
+public:
+    // @throws std::invalid_argument при dims = 0 или design_size вне [1, 2^32]
+    LatinHypercube(unsigned dims, std::uint64_t design_size, std::uint32_t seed);
+
+    // Точка с номером index < design_size, значения в (0, 1)
+    void sample(std::uint64_t index, double* out) const;
+
+    unsigned dims() const { return dim_count; }
+    std::uint64_t size() const { return design_size; }
+
+private:
+    unsigned dim_count;
+    std::uint64_t design_size;
+    std::uint32_t seed;
+};
+
+enum SamplerKind { SAMPLER_SOBOL, SAMPLER_LATIN_HYPERCUBE };
+
+bool parseSamplerKind(const std::string& name, SamplerKind& kind);
+
+// Закон распределения одного параметра VehicleParams
+struct ParameterDistribution {
+    enum Law { UNIFORM, NORMAL };
+
+    std::string field;   // имя поля VehicleParams: V0, theta_c0, m_dot, W, y0, ...
+    Law law;
+    double a;            // UNIFORM: нижняя граница, NORMAL: среднее
+    double b;            // UNIFORM: верхняя граница, NORMAL: СКО
+};
+
+/**
+ * Файл разброса: по параметру в строке, строки с '#' пропускаются
+ *   <поле> uniform <min> <max>
+ *   <поле> normal <среднее> <СКО>
+ * @throws std::runtime_error если файл не открыт или строка некорректна
+ */
+std::vector<ParameterDistribution> loadDispersionSpec(const std::string& filename);
+
+// Обратная функция стандартного нормального распределения, p в (0, 1)
+double inverseNormalCdf(double p);
+
+/**
+ * Случаи с номерами [first, first + count) общей выборки: параметры из spec
+ * заменяются выборочными значениями, остальные берутся из base.
+ * Имя случая - base.name + "_" + номер.
+ * @param design_size - размер латинского гиперкуба (не меньше first + count),
+ *                      для Соболя не используется
+ * @throws std::invalid_argument при неизвестном поле или некорректных размерах
+ */
+std::vector<BatchCase> sampleBatchCases(const BatchCase& base, const std::vector<ParameterDistribution>& spec,
+                                        SamplerKind kind, std::uint64_t first, std::uint64_t count,
+                                        std::uint64_t design_size, std::uint32_t seed);
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <string>
+#include <vector>
+#include "batch.h"
+
+/*
+ * Пакетный расчёт в нескольких процессах.
+ *
+ * Список случаев делится на shards последовательных частей (шардов). Каждый
+ * шард считает отдельный процесс-исполнитель (trajectory_calc --batch-worker)
+ * и записывает результат в свой файл каталога <directory>/shards - сначала во
+ * временный, затем переименованием, поэтому файл либо полный, либо его нет.
+ * Исполнители можно запускать и на других машинах с общим каталогом:
+ * координатор (runShardedBatch) запускает только шарды без готового файла,
+ * перезапускает упавшие и объединяет файлы по возрастанию номеров случаев.
+ * Результат объединения от числа шардов не зависит:
+ *   end_states.txt   - конечные состояния в формате пакетного режима;
+ *   trajectories.bin - траектории случаев подряд (формат - mergeShards);
+ *   summary.txt      - число случаев и среднее, минимум, максимум конечных величин.
+ *
+ * Файл шарда (порядок байт платформы):
+ *   "BALSHRD1", u64 отпечаток, u64 число случаев, u32 шард, u32 шардов, u64 first, u64 last;
+ *   записи в порядке завершения: u64 номер случая, u64 число точек, точки TrajectoryPoint;
+ *   таблица смещений записей для номеров first..last-1, u64 смещение таблицы, "BALSHRD1".
+ */
+
+// Случаи шарда: номера [first, last)
+struct ShardRange {
+    size_t first;
+    size_t last;
+};
+
+ShardRange shardRange(size_t case_count, unsigned shard, unsigned shards);
+
+// Имя файла шарда в каталоге directory
+std::string shardFileName(const std::string& directory, unsigned shard, unsigned shards);
+
+/**
+ * Отпечаток расчёта: список случаев и параметры расчёта в виде аргументов
+ * командной строки (--aero, --pitch, ...). Файлы шардов с другим отпечатком
+ * не используются.
+ */
+unsigned long long shardFingerprint(const std::vector<BatchCase>& cases,
+                                    const std::vector<std::string>& batch_arguments);
+
+/**
+ * Расчёт шарда в этом процессе и запись его файла. Случай, который не
+ * рассчитан, записывается с пустой траекторией (mergeShards считает такие
+ * случаи в ShardReport::failed_cases).
+ * @return false, если файл не записан (сообщение в std::cerr)
+ */
+bool runShardWorker(const std::vector<BatchCase>& cases, unsigned shard, unsigned shards,
+                    const BatchOptions& options, unsigned long long fingerprint,
+                    const std::string& directory);
+
+// @return true, если файл шарда полный и относится к этому расчёту
+bool shardFileValid(const std::string& filename, unsigned long long fingerprint, size_t case_count,
+                    unsigned shard, unsigned shards);
+
+struct ShardReport {
+    unsigned launched = 0;     // запусков исполнителей, включая повторные
+    unsigned retried = 0;      // повторных запусков
+    unsigned reused = 0;       // шардов с готовым файлом
+    size_t cases = 0;          // случаев в объединённом результате
+    size_t failed_cases = 0;   // из них с пустой траекторией
+};
+
+/**
+ * Объединение файлов шардов в end_states.txt, trajectories.bin и summary.txt
+ * каталога directory. trajectories.bin: "BALTRJ01", u64 число случаев, затем для
+ * каждого случая u64 номер, u64 число точек и точки TrajectoryPoint.
+ * @return false, если файла шарда нет или он повреждён (сообщение в std::cerr)
+ */
+bool mergeShards(const std::vector<BatchCase>& cases, unsigned shards, unsigned long long fingerprint,
+                 const std::string& directory, ShardReport* report = nullptr);
+
+struct ShardOptions {
+    unsigned shards = 1;
+    unsigned workers = 0;            // одновременно работающих исполнителей; 0 - по числу ядер
+    unsigned retries = 2;            // повторных запусков упавшего шарда
+    std::string directory = "results/sharded";
+    std::vector<std::string> batch_arguments;   // передаются исполнителям как есть
+};
+
+/**
+ * Координатор: запуск исполнителей executable (fork/exec, только POSIX),
+ * повтор упавших, объединение.
+ * @return false, если шард не удался после всех повторов или объединение не выполнено
+ */
+bool runShardedBatch(const std::string& executable, const std::string& cases_file,
+                     const std::vector<BatchCase>& cases, const ShardOptions& options,
+                     ShardReport* report = nullptr);
+
+#endif
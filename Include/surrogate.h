@@ -0,0 +1,114 @@
+#ifndef SURROGATE_H
+#define SURROGATE_H
+
+#include <vector>
+#include <string>
+#include "batch.h"
+#include "lookup_table.h"
+
+/*
+ * Суррогатная модель конечного состояния траектории.
+ *
+ * Заранее (build) базовый случай рассчитывается параллельно в узлах
+ * равномерной сетки по выбранным полям VehicleParams (V0, theta_c0, m0, y0, ...),
+ * конечные состояния записываются в LookupTable. Для каждой ячейки сетки
+ * дополнительно считается случай в её центре: отличие каждой компоненты точного
+ * конечного состояния (t, x, y, V, theta_c, m) от полилинейной интерполяции -
+ * оценка ошибки ячейки (карты ошибок, хранятся в узле нижнего угла ячейки).
+ *
+ * Запрос (evaluate) отвечается интерполяцией за микросекунды, если параметры
+ * внутри сетки, остальные поля совпадают с базовым случаем и ошибки ячейки
+ * по всем компонентам не больше допусков SurrogateTolerance; иначе выполняется
+ * обычный расчёт.
+ *
+ * Файл сетки (строки с '#' пропускаются):
+ *   <поле> <min> <max> <число узлов>
+ */
+struct SurrogateAxis {
+    std::string field;   // имя поля VehicleParams
+    double min;
+    double max;
+    size_t nodes;        // не меньше 2
+};
+
+// @throws std::runtime_error если файл не открыт или строка некорректна
+std::vector<SurrogateAxis> loadSurrogateGrid(const std::string& filename);
+
+// Конечное состояние траектории
+struct SurrogateState {
+    double t = 0.0;
+    double x = 0.0;
+    double y = 0.0;
+    double V = 0.0;
+    double theta_c = 0.0;
+    double m = 0.0;
+};
+
+// Допустимые ошибки интерполяции по компонентам конечного состояния
+struct SurrogateTolerance {
+    double t = 1e-3;          // с
+    double position = 1.0;    // x и y, м
+    double V = 0.1;           // м/с
+    double theta_c = 0.01;    // град
+    double m = 0.1;           // кг
+};
+
+struct SurrogateBuildReport {
+    size_t nodes = 0;
+    size_t cells = 0;
+    SurrogateState max_error;    // наибольшие ошибки ячеек по компонентам
+    SurrogateState mean_error;
+    double seconds = 0.0;
+};
+
+class TrajectorySurrogate {
+public:
+    // t x y V theta_c m, затем ошибки ячейки по ним же
+    static const size_t STATE_COMPONENTS = 6;
+    static const size_t COMPONENTS = 2 * STATE_COMPONENTS;
+
+    /**
+     * Расчёт сетки; method, alpha_law и dt берутся из base.
+     * @return false, если хотя бы один случай не рассчитан (сообщение в std::cerr)
+     * @throws std::invalid_argument при некорректных осях
+     */
+    static bool build(const BatchCase& base, const std::vector<SurrogateAxis>& axes, unsigned threads,
+                      TrajectorySurrogate& surrogate, SurrogateBuildReport* report = nullptr);
+
+    /**
+     * @return false при ошибке записи
+     */
+    bool save(const std::string& filename) const;
+
+    /**
+     * Загрузка таблицы, построенной для base (поля сетки в base не учитываются)
+     * @return false, если файла нет, он повреждён или построен для другого случая
+     */
+    static bool load(const std::string& filename, const BatchCase& base, TrajectorySurrogate& surrogate);
+
+    /**
+     * Ошибки ячейки, содержащей params, по компонентам конечного состояния
+     * @return false, если таблица к params неприменима (вне сетки или другие
+     *         значения остальных полей)
+     */
+    bool cellError(const VehicleParams& params, SurrogateState& error) const;
+
+    /**
+     * Конечное состояние: из таблицы, если ошибки ячейки в пределах tolerance,
+     * иначе расчётом. Исключения расчёта передаются вызывающему.
+     * @param from_table - признак ответа из таблицы или nullptr
+     */
+    SurrogateState evaluate(const VehicleParams& params, const SurrogateTolerance& tolerance,
+                            bool* from_table = nullptr) const;
+
+    size_t dims() const { return fields.size(); }
+    const std::vector<SurrogateAxis>& axes() const { return grid; }
+
+private:
+    BatchCase base;
+    std::vector<SurrogateAxis> grid;
+    std::vector<size_t> fields;     // номера полей VehicleParams по осям
+    LookupTable table;
+};
+
+#endif
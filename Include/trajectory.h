@@ -3,9 +3,20 @@
 
 #include <vector>
 #include <string>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <iostream>
 #include "atmosphere.h"
 
-enum IntegrationMethod { EULER, MODIFIED_EULER, RUNGE_KUTTA_4 };
+struct DownsampleTolerance;
+class AtmosphereProfile;
+class AeroDatabase;
+class TrajectoryTable;
+
+// ROSENBROCK - линейно-неявный метод ROS2 для жёсткой динамики тангажа
+enum IntegrationMethod { EULER, MODIFIED_EULER, RUNGE_KUTTA_4, ROSENBROCK };
 enum AlphaLaw { ALPHA_THETA_MINUS_THETAC, ALPHA_ZERO };
 
 struct TrajectoryPoint {
@@ -28,45 +39,214 @@ struct TrajectoryPoint {
     double V_dot;   // производная скорости (ускорение)
 };
 
+// Вектор состояния: V, theta_c, x, y, omega_z, theta, m
+typedef std::array<double, 7> StateVector;
+
+// Исходные данные ЛА (параметры конструктора TrajectoryCalculator)
+struct VehicleParams {
+    double V0, theta_c0, m_dot, W, y0, omega_z0, theta0;
+    double t_end, m0, I_d, S_a, S_m;
+};
+
+// Наибольшие число Маха и высота, при которых вычислялись аэродинамика и атмосфера
+// (во всех стадиях шагов и точках траектории); по ним кэш префиксов (prefix_cache.h)
+// определяет, затрагивает ли изменение модели уже рассчитанную часть траектории
+struct FlightEnvelope {
+    double max_mach = 0.0;
+    double max_altitude = 0.0;
+};
+
+// Состояние интегратора, достаточное для продолжения расчёта
+struct IntegratorState {
+    double t;
+    StateVector state;
+    IntegrationMethod method;
+    AlphaLaw alpha_law;
+    double dt;
+    unsigned long long steps;   // выполненные шаги интегрирования
+    FlightEnvelope envelope;    // с начала траектории; в контрольные точки не пишется
+};
+
+// Вращательное движение по тангажу (по умолчанию выключено: omega_z = const).
+// Момент: восстанавливающий от подъёмной силы на плече запаса устойчивости I_d
+// и демпфирующий: Mz = -Ya*I_d + mz_omegaz*q*S_m*L*(omega_z*L/V).
+// Момент инерции пропорционален массе: I_z = I_z0*m/m0.
+struct PitchDynamics {
+    bool enabled = false;
+    double I_z0 = 0.0;        // момент инерции при m0, кг·м²
+    double L = 0.0;           // характерная длина, м
+    double mz_omegaz = 0.0;   // коэффициент демпфирующего момента (< 0)
+};
+
+// Команды управления шаговому расчёту (realtime_stepper.h); NaN - команды нет
+struct ControlCommand {
+    double omega_z = NAN;   // угловая скорость тангажа, град/с; выдерживается идеальным приводом
+    double alpha = NAN;     // угол атаки, град; вместо закона AlphaLaw
+};
+
+// Курсоры поиска вдоль одной траектории: последний слой атмосферы и интервал
+// таблицы по числу Маха. Поиск начинается с них и проверяет соседей, поэтому
+// при плавном движении почти всегда O(1); результат тот же, что без курсоров.
+struct LookupCursors {
+    AtmosphereCursor atmosphere = {0};
+    size_t mach_interval = 0;
+    size_t aero_intervals[3] = {0, 0, 0};  // по осям аэродинамической базы
+    FlightEnvelope envelope;                // обновляется при каждом обращении к моделям
+};
+
+// Периодический вызов во время интегрирования (для контрольных точек)
+struct CheckpointHook {
+    unsigned long long interval;  // шагов между вызовами
+    std::function<void(const IntegratorState&, const std::vector<TrajectoryPoint>&)> callback;
+};
+
 class TrajectoryCalculator {
 private:
     double V0, theta_c0, m_dot, W, y0, omega_z0, theta0;
     double t_end, m0, I_d, S_a, S_m;
     
+    // Профиль атмосферы (nullptr - стандартная атмосфера)
+    std::shared_ptr<const AtmosphereProfile> atmosphere_profile;
+    
+    // Аэродинамическая база (nullptr - встроенные таблицы по числу Маха)
+    std::shared_ptr<const AeroDatabase> aero_database;
+    
+    PitchDynamics pitch;
+    
+    // Режим быстрой физики (setFastMath)
+    bool fast_math = false;
+    
 public:
     TrajectoryCalculator(double V0, double theta_c0, double m_dot, double W,
                         double y0, double omega_z0, double theta0,
                         double t_end, double m0, double I_d, double S_a, double S_m);
+    explicit TrajectoryCalculator(const VehicleParams& params);
+    
+    VehicleParams params() const;
+    
+    // Выбор атмосферы для этого калькулятора (nullptr - стандартная атмосфера)
+    void setAtmosphereProfile(std::shared_ptr<const AtmosphereProfile> profile);
+    const std::shared_ptr<const AtmosphereProfile>& atmosphereProfile() const { return atmosphere_profile; }
+    
+    // Выбор аэродинамической базы (nullptr - встроенные таблицы)
+    void setAeroDatabase(std::shared_ptr<const AeroDatabase> database);
+    const std::shared_ptr<const AeroDatabase>& aeroDatabase() const { return aero_database; }
+    
+    // Динамика тангажа; @throws std::invalid_argument при I_z0 <= 0 или L <= 0
+    void setPitchDynamics(const PitchDynamics& dynamics);
+    const PitchDynamics& pitchDynamics() const { return pitch; }
+    
+    // Быстрая физика: давление стандартной атмосферы - calculate_atmosphere_fast.
+    // Результат отличается от точного в пределах погрешности, проверяемой
+    // fastMathSelfTest (fast_math.h); по умолчанию выключена
+    void setFastMath(bool enabled);
+    bool fastMath() const { return fast_math; }
     
     // Методы интегрирования
     std::vector<TrajectoryPoint> calculateTrajectory(IntegrationMethod method, 
                                                      AlphaLaw alpha_law, 
                                                      double dt) const;
     
+    // То же в буфер trajectory: он очищается, ёмкость сохраняется и при необходимости
+    // увеличивается до expectedPointCount(dt). @return false при ошибке (буфер пуст)
+    bool calculateTrajectory(IntegrationMethod method, AlphaLaw alpha_law, double dt,
+                             std::vector<TrajectoryPoint>& trajectory) const;
+    
+    // Верхняя оценка числа точек траектории с шагом dt (для заблаговременного выделения)
+    size_t expectedPointCount(double dt) const;
+    
+    // Начальное состояние интегратора (t = 0)
+    IntegratorState initialState(IntegrationMethod method, AlphaLaw alpha_law, double dt) const;
+    
+    // Продолжение расчёта с состояния state до t_end; trajectory дополняется.
+    // При state.steps == 0 и пустой trajectory добавляется начальная точка.
+    // stop_step - номер шага, на котором расчёт приостанавливается (конечная
+    // точка тогда не добавляется, расчёт можно продолжить тем же вызовом).
+    void continueTrajectory(IntegratorState& state, std::vector<TrajectoryPoint>& trajectory,
+                            const CheckpointHook* hook = nullptr,
+                            unsigned long long stop_step = ~0ULL) const;
+    
+    // То же с записью в столбцы (trajectory_table.h): сохраняются только выбранные
+    // каналы, производные величины в точках сохранения не вычисляются
+    void continueTrajectory(IntegratorState& state, TrajectoryTable& table,
+                            unsigned long long stop_step = ~0ULL) const;
+    
+    // Расчёт в таблицу (очищается); @return false при ошибке (таблица пуста)
+    bool calculateTrajectory(IntegrationMethod method, AlphaLaw alpha_law, double dt,
+                             TrajectoryTable& table) const;
+    
+    // Точка траектории со всеми полями по состоянию в момент t;
+    // cursors - курсоры поиска для серии соседних точек или nullptr
+    TrajectoryPoint pointAt(double t, const StateVector& state, AlphaLaw alpha_law,
+                            LookupCursors* cursors = nullptr) const;
+    
+    // g, M, Cxa и Cya_alpha по столбцам высоты и скорости пакетными ядрами (kernels.h),
+    // значения те же, что у pointAt. Только для стандартной атмосферы, встроенных
+    // таблиц и точной физики: @return false, если заданы профиль атмосферы,
+    // аэродинамическая база или быстрая физика
+    bool aerodynamicColumns(const double* y, const double* V, size_t count,
+                            double* g, double* M, double* Cxa, double* Cya_alpha) const;
+    
 private:
+    // Приёмники точек общего цикла интегрирования
+    struct PointSink;
+    struct TableSink;
+    
+    template <class Sink>
+    void integrate(IntegratorState& state, Sink& sink, const CheckpointHook* hook,
+                   unsigned long long stop_step) const;
+    
+
     // Вспомогательные методы
-    void addTrajectoryPoint(std::vector<TrajectoryPoint>& trajectory, double t, 
-                           const std::vector<double>& state, 
-                           const std::vector<double>& derivatives,
-                           AlphaLaw alpha_law) const;
+    bool atmosphereCovers(double y) const;
+    AtmosphereParams atmosphereAt(double y, double& wind, LookupCursors& cursors) const;
+    
+    TrajectoryPoint makeTrajectoryPoint(double t, const StateVector& state,
+                                        const StateVector& derivatives,
+                                        AlphaLaw alpha_law, LookupCursors& cursors) const;
+    
+    // Блок матрицы Якоби тангажа: d(domega_z/dt)/d(theta), d(domega_z/dt)/d(omega_z);
+    // d(dtheta/dt)/d(omega_z) = 1
+    struct PitchJacobian {
+        double omega_theta;
+        double omega_omega;
+    };
+    
+    // command - команды управления (RealtimeStepper) или nullptr
+    void calculateDerivatives(double t, const StateVector& state,
+                             StateVector& derivatives, 
+                             AlphaLaw alpha_law, LookupCursors& cursors,
+                             PitchJacobian* jacobian = nullptr,
+                             const ControlCommand* command = nullptr) const;
     
-    void calculateDerivatives(double t, const std::vector<double>& state,
-                             std::vector<double>& derivatives, 
-                             AlphaLaw alpha_law) const;
+    // Один шаг интегрирования (без защиты финальных значений)
+    void stepEuler(double t, StateVector& state, double dt, AlphaLaw alpha_law,
+                   LookupCursors& cursors, const ControlCommand* command = nullptr) const;
+    void stepModifiedEuler(double t, StateVector& state, double dt, AlphaLaw alpha_law,
+                   LookupCursors& cursors, const ControlCommand* command = nullptr) const;
+    void stepRungeKutta4(double t, StateVector& state, double dt, AlphaLaw alpha_law,
+                   LookupCursors& cursors, const ControlCommand* command = nullptr) const;
+    void stepRosenbrock(double t, StateVector& state, double dt, AlphaLaw alpha_law,
+                   LookupCursors& cursors, const ControlCommand* command = nullptr) const;
     
-    std::vector<TrajectoryPoint> integrateEuler(double dt, AlphaLaw alpha_law) const;
-    std::vector<TrajectoryPoint> integrateModifiedEuler(double dt, AlphaLaw alpha_law) const;
-    std::vector<TrajectoryPoint> integrateRungeKutta4(double dt, AlphaLaw alpha_law) const;
+    friend class RealtimeStepper;
     
 public:
-    void printResultsTable(const std::vector<TrajectoryPoint>& trajectory) const;
+    // out - поток вывода таблицы и сообщений о сохранении (например, AsyncWriter)
+    void printResultsTable(const std::vector<TrajectoryPoint>& trajectory,
+                           std::ostream& out = std::cout) const;
+    // tolerance - допуски прореживания (downsampling.h), nullptr - без прореживания
     void saveResultsToFile(const std::vector<TrajectoryPoint>& trajectory, 
-                          const std::string& filename) const;
+                          const std::string& filename,
+                          const DownsampleTolerance* tolerance = nullptr,
+                          std::ostream& out = std::cout) const;
 
 
 public:
     void saveGraphData(const std::vector<TrajectoryPoint>& trajectory, 
-                      const std::string& base_filename) const;
+                      const std::string& base_filename,
+                      const DownsampleTolerance* tolerance = nullptr,
+                      std::ostream& out = std::cout) const;
 
 
 };
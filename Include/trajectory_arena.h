@@ -0,0 +1,32 @@
+#ifndef TRAJECTORY_ARENA_H
+#define TRAJECTORY_ARENA_H
+
+#include <vector>
+#include "trajectory.h"
+
+/*
+ * Арена буферов траекторий для серии расчётов (пакет, сервис).
+ *
+ * Буферы не освобождаются между расчётами: acquire() очищает буфер и при
+ * необходимости увеличивает ёмкость до ожидаемого числа точек
+ * (TrajectoryCalculator::expectedPointCount). После первых случаев пакета
+ * выделений памяти нет, а занимаемая память ограничена самым длинным
+ * случаем на буфер. Каждый буфер используется одним потоком.
+ */
+class TrajectoryArena {
+public:
+    explicit TrajectoryArena(size_t buffer_count);
+
+    // Буфер с номером index: пустой, ёмкость не меньше expected_points
+    std::vector<TrajectoryPoint>& acquire(size_t index, size_t expected_points);
+
+    // То же для буфера вне арены (например, thread_local)
+    static void prepare(std::vector<TrajectoryPoint>& buffer, size_t expected_points);
+
+    size_t bufferCount() const { return buffers.size(); }
+
+private:
+    std::vector<std::vector<TrajectoryPoint>> buffers;
+};
+
+#endif
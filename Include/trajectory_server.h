@@ -0,0 +1,35 @@
+#ifndef TRAJECTORY_SERVER_H
+#define TRAJECTORY_SERVER_H
+
+#include <string>
+#include <iosfwd>
+
+/*
+ * Долгоживущий сервис расчёта траекторий.
+ *
+ * Протокол строчный. Запрос - строка случая в формате batch.h, где имя
+ * служит идентификатором запроса:
+ *   id V0 theta_c0 m_dot W y0 omega_z0 theta0 t_end m0 I_d S_a S_m method alpha_law dt
+ * Повтор запроса, отличающегося только t_end, продолжает расчёт с сохранённого
+ * снимка потока (prefix_cache.h) - ответ тот же, что при полном расчёте.
+ * Ответ (запросы обрабатываются параллельно, порядок ответов не гарантирован):
+ *   id OK t x y V theta_c m latency_us
+ *   id ERR сообщение
+ * Служебные команды:
+ *   STATS     -> STATS count p50_us p99_us max_us
+ *   QUIT      - закрыть соединение
+ *   SHUTDOWN  - остановить сервер
+ */
+
+struct ServerOptions {
+    std::string socket_path;   // "-" - stdin/stdout вместо сокета
+    unsigned threads = 0;      // 0 - по числу ядер
+};
+
+// @return код завершения процесса
+int runTrajectoryServer(const ServerOptions& options);
+
+// Клиент: запросы из in отправляются на сервер, ответы выводятся в out
+int runTrajectoryClient(const std::string& socket_path, std::istream& in, std::ostream& out);
+
+#endif
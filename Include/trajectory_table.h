@@ -0,0 +1,102 @@
+#ifndef TRAJECTORY_TABLE_H
+#define TRAJECTORY_TABLE_H
+
+#include <vector>
+#include <string>
+#include "trajectory.h"
+
+// Каналы траектории в порядке полей TrajectoryPoint
+enum TrajectoryChannel {
+    // Состояние - хранится в таблице
+    CHANNEL_T, CHANNEL_V, CHANNEL_THETA_C, CHANNEL_X, CHANNEL_Y,
+    CHANNEL_OMEGA_Z, CHANNEL_THETA, CHANNEL_MASS,
+    // Производные величины - вычисляются по состоянию при запросе
+    CHANNEL_P, CHANNEL_G, CHANNEL_MACH, CHANNEL_CXA, CHANNEL_CYA_ALPHA,
+    CHANNEL_ALPHA, CHANNEL_X_DOT, CHANNEL_Y_DOT, CHANNEL_V_DOT,
+    CHANNEL_COUNT
+};
+
+const unsigned STATE_CHANNELS = (1u << (CHANNEL_MASS + 1)) - 1;
+
+inline unsigned channelBit(TrajectoryChannel channel) { return 1u << channel; }
+
+// Имена каналов совпадают с полями TrajectoryPoint (t, V, theta_c, ..., M, ..., V_dot)
+const char* channelName(TrajectoryChannel channel);
+
+/**
+ * Разбор списка каналов через запятую ("t,x,y"; "state" - всё состояние)
+ * @return false при неизвестном имени
+ */
+bool parseTrajectoryChannels(const std::string& list, unsigned& mask);
+
+/*
+ * Траектория по столбцам (structure of arrays).
+ *
+ * Хранятся только выбранные каналы состояния: 8 байт на точку на канал
+ * вместо sizeof(TrajectoryPoint) = 136. Производные величины (P, g, M, Cxa,
+ * Cya_alpha, alpha, скорости и ускорение) не хранятся, а вычисляются
+ * по состоянию тем же кодом, что заполняет TrajectoryPoint, поэтому
+ * совпадают с ним побитово; для этого нужно всё состояние (STATE_CHANNELS).
+ * Столбцы непрерывны, их просмотр векторизуется компилятором.
+ *
+ * Заполняется TrajectoryCalculator::continueTrajectory(state, table).
+ */
+class TrajectoryTable {
+public:
+    // Выбранные каналы производных величин означают всё состояние
+    explicit TrajectoryTable(unsigned channels = STATE_CHANNELS);
+
+    unsigned channels() const { return mask; }
+    bool has(TrajectoryChannel channel) const { return (mask & channelBit(channel)) != 0; }
+    bool canDerive() const { return (mask & STATE_CHANNELS) == STATE_CHANNELS; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    double lastTime() const { return last_t; }
+    AlphaLaw alphaLaw() const { return alpha_law; }
+
+    // Очистка с сохранением ёмкости; alpha_law - закон расчёта, который заполнит таблицу
+    void clear(AlphaLaw law = ALPHA_THETA_MINUS_THETAC);
+    void reserve(size_t points);
+
+    // Точка t, state: записываются только выбранные каналы
+    void append(double t, const StateVector& state);
+
+    /**
+     * Столбец хранимого канала, size() значений
+     * @throws std::invalid_argument, если канал не выбран или не хранится
+     */
+    const double* column(TrajectoryChannel channel) const;
+
+    // Состояние точки i; @throws std::logic_error без всего состояния
+    StateVector state(size_t i) const;
+
+    /**
+     * Точка i со всеми полями, производные - по модели calculator
+     * (тот же калькулятор, которым рассчитана траектория)
+     * @throws std::logic_error без всего состояния
+     */
+    TrajectoryPoint point(size_t i, const TrajectoryCalculator& calculator) const;
+
+    /**
+     * Столбец любого канала; производные считаются по всем точкам
+     * @throws std::logic_error для производного канала без всего состояния
+     */
+    void derive(TrajectoryChannel channel, const TrajectoryCalculator& calculator,
+                std::vector<double>& out) const;
+
+    // Преобразование в массив TrajectoryPoint (для сохранения и вывода)
+    void toPoints(const TrajectoryCalculator& calculator, std::vector<TrajectoryPoint>& out) const;
+
+    // Память, занятая столбцами, байт
+    size_t capacityBytes() const;
+
+private:
+    unsigned mask;
+    size_t count = 0;
+    double last_t = 0.0;
+    AlphaLaw alpha_law = ALPHA_THETA_MINUS_THETAC;
+    std::vector<double> columns[CHANNEL_MASS + 1];
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "aero_database.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+namespace {
+
+// Версия формата кэша (meta[3]); меняется при изменении разбора
+const std::uint64_t CACHE_VERSION = 1;
+
+const char* const AXIS_NAMES[AeroDatabase::MAX_AXES] = {"M", "alpha", "H"};
+
+// Размер и время изменения текстового файла для проверки кэша
+bool source_stamp(const std::string& filename, std::uint64_t& size, std::uint64_t& mtime) {
+    std::error_code error;
+    size = static_cast<std::uint64_t>(std::filesystem::file_size(filename, error));
+    if (error) return false;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(filename, error);
+    if (error) return false;
+    mtime = static_cast<std::uint64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+// Номер узла с координатой value на оси или -1
+long node_index(const std::vector<double>& axis, double value) {
+    std::vector<double>::const_iterator it = std::lower_bound(axis.begin(), axis.end(), value);
+    if (it == axis.end() || *it != value) return -1;
+    return static_cast<long>(it - axis.begin());
+}
+
+// Разбор текстового файла; mask - заданные оси (биты в порядке M, alpha, H)
+LookupTable parse_text(const std::string& filename, unsigned& mask) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Ошибка открытия аэродинамической базы: " + filename);
+    }
+    const std::string where = "Аэродинамическая база " + filename;
+
+    std::vector<std::vector<double>> axes;
+    std::vector<double> values;
+    std::vector<unsigned char> filled;
+    size_t filled_count = 0;
+    mask = 0;
+
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        const std::string at = where + ", строка " + std::to_string(line_number) + ": ";
+
+        std::istringstream in(line);
+        if (line.compare(first, 4, "axis") == 0) {
+            if (!values.empty()) {
+                throw std::runtime_error(at + "оси задаются до узлов");
+            }
+            std::string keyword, name;
+            in >> keyword >> name;
+            size_t role = 0;
+            while (role < AeroDatabase::MAX_AXES && name != AXIS_NAMES[role]) ++role;
+            if (role == AeroDatabase::MAX_AXES || (mask >> role) != 0 || (role > 0 && (mask & 1u) == 0)) {
+                throw std::runtime_error(at + "ожидается ось M, затем alpha и/или H");
+            }
+            std::vector<double> nodes;
+            double value;
+            while (in >> value) nodes.push_back(value);
+            if (nodes.empty() || !in.eof()) {
+                throw std::runtime_error(at + "некорректные узлы оси " + name);
+            }
+            for (size_t i = 1; i < nodes.size(); ++i) {
+                if (!(nodes[i] > nodes[i - 1])) {
+                    throw std::runtime_error(at + "узлы оси " + name + " должны строго возрастать");
+                }
+            }
+            axes.push_back(nodes);
+            mask |= 1u << role;
+            continue;
+        }
+
+        if (axes.empty()) {
+            throw std::runtime_error(at + "не задана ось M");
+        }
+        if (values.empty()) {
+            size_t nodes = 1;
+            for (const std::vector<double>& a : axes) nodes *= a.size();
+            values.assign(nodes * 2, 0.0);
+            filled.assign(nodes, 0);
+        }
+
+        size_t index = 0;
+        for (const std::vector<double>& a : axes) {
+            double coordinate;
+            long i = (in >> coordinate) ? node_index(a, coordinate) : -1;
+            if (i < 0) {
+                throw std::runtime_error(at + "координата не совпадает с узлом сетки");
+            }
+            index = index * a.size() + static_cast<size_t>(i);
+        }
+        double Cxa, Cya_alpha;
+        if (!(in >> Cxa >> Cya_alpha)) {
+            throw std::runtime_error(at + "ожидаются Cxa и Cya_alpha");
+        }
+        if (filled[index]) {
+            throw std::runtime_error(at + "узел задан повторно");
+        }
+        filled[index] = 1;
+        ++filled_count;
+        values[index * 2] = Cxa;
+        values[index * 2 + 1] = Cya_alpha;
+    }
+
+    if (values.empty() || filled_count != filled.size()) {
+        throw std::runtime_error(where + ": заданы не все узлы сетки (" +
+                                 std::to_string(filled_count) + " из " + std::to_string(filled.size()) + ")");
+    }
+    return LookupTable(axes, 2, values);
+}
+
+} // namespace
+
+AeroDatabase::AeroDatabase(const LookupTable& table, unsigned axis_mask, bool from_cache)
+    : table(table), axis_mask(axis_mask), from_cache(from_cache) {
+}
+
+std::shared_ptr<const AeroDatabase> AeroDatabase::load(const std::string& filename) {
+    const std::string cache_name = filename + ".bin";
+    std::uint64_t size = 0, mtime = 0;
+    bool stamped = source_stamp(filename, size, mtime);
+
+    LookupTable table;
+    LookupTable::Meta meta;
+    if (stamped && LookupTable::mapBinary(cache_name, table, meta) &&
+        meta[0] == size && meta[1] == mtime && meta[3] == CACHE_VERSION &&
+        table.components() == 2 && (meta[2] & 1u) != 0 && meta[2] < (1u << MAX_AXES) &&
+        table.dims() == static_cast<size_t>(1 + ((meta[2] >> 1) & 1u) + ((meta[2] >> 2) & 1u))) {
+        return std::make_shared<const AeroDatabase>(table, static_cast<unsigned>(meta[2]), true);
+    }
+
+    unsigned mask = 0;
+    table = parse_text(filename, mask);
+    if (stamped) {
+        meta = {size, mtime, mask, CACHE_VERSION};
+        if (!table.saveBinary(cache_name, meta)) {
+            std::cerr << "Не удалось записать кэш аэродинамической базы " << cache_name << std::endl;
+        }
+    }
+    return std::make_shared<const AeroDatabase>(table, mask, false);
+}
+
+void AeroDatabase::evaluate(double M, double alpha_deg, double altitude,
+                            double& Cxa, double& Cya_alpha, size_t* intervals) const {
+    double x[MAX_AXES];
+    size_t dims = 0;
+    x[dims++] = M;
+    if (axis_mask & AXIS_ALPHA) x[dims++] = alpha_deg;
+    if (axis_mask & AXIS_H) x[dims++] = altitude;
+
+    double out[2];
+    table.interpolate(x, out, intervals);
+    Cxa = out[0];
+    Cya_alpha = out[1];
+}
+
+void AeroDatabase::appendContent(std::string& out) const {
+    auto append = [&out](const void* data, size_t size) {
+        out.append(static_cast<const char*>(data), size);
+    };
+    const std::uint64_t mask = axis_mask, dims = table.dims();
+    append(&mask, sizeof(mask));
+    append(&dims, sizeof(dims));
+    for (size_t d = 0; d < table.dims(); ++d) {
+        const std::uint64_t length = table.axisSize(d);
+        append(&length, sizeof(length));
+        append(table.axis(d), length * sizeof(double));
+    }
+    append(table.values(), table.nodeCount() * table.components() * sizeof(double));
+}
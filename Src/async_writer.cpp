@@ -0,0 +1,180 @@
+#include "async_writer.h"
+#include <streambuf>
+#include <vector>
+#include <stdexcept>
+#include <utility>
+#include <algorithm>
+
+// Двойной буфер вывода: заполняется один, второй в это время пишется в target
+class AsyncWriter::OutputBuffer : public std::streambuf {
+public:
+    OutputBuffer(std::ostream& target, size_t bytes)
+        : target(target), active(bytes), pending(bytes) {
+        setp(active.data(), active.data() + active.size());
+        flusher = std::thread(&OutputBuffer::flushLoop, this);
+    }
+
+    ~OutputBuffer() override {
+        handOff();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        flusher.join();
+    }
+
+    // Ожидание записи переданного буфера
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return pending_size == 0; });
+    }
+
+protected:
+    int overflow(int ch) override {
+        handOff();
+        if (ch != traits_type::eof()) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        std::streamsize written = 0;
+        while (written < n) {
+            if (pptr() == epptr()) handOff();
+            std::streamsize chunk = std::min<std::streamsize>(n - written, epptr() - pptr());
+            traits_type::copy(pptr(), s + written, static_cast<size_t>(chunk));
+            pbump(static_cast<int>(chunk));
+            written += chunk;
+        }
+        return written;
+    }
+
+    // flush потока (в том числе std::endl) - передача буфера без ожидания записи
+    int sync() override {
+        handOff();
+        return 0;
+    }
+
+private:
+    void handOff() {
+        size_t size = static_cast<size_t>(pptr() - pbase());
+        if (size == 0) return;
+        std::unique_lock<std::mutex> lock(mutex);
+        // Второй буфер ещё пишется - ждём (запись в target медленнее форматирования)
+        changed.wait(lock, [this]() { return pending_size == 0; });
+        active.swap(pending);
+        pending_size = size;
+        lock.unlock();
+        changed.notify_all();
+        setp(active.data(), active.data() + active.size());
+    }
+
+    void flushLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            changed.wait(lock, [this]() { return stopping || pending_size != 0; });
+            if (pending_size == 0) return;   // stopping и нечего писать
+            size_t size = pending_size;
+            lock.unlock();
+            target.write(pending.data(), static_cast<std::streamsize>(size));
+            target.flush();
+            lock.lock();
+            pending_size = 0;
+            changed.notify_all();
+        }
+    }
+
+    std::ostream& target;
+    std::vector<char> active;
+    std::vector<char> pending;
+    size_t pending_size = 0;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread flusher;
+};
+
+AsyncWriter::AsyncWriter(std::ostream& target, size_t queue_capacity, size_t buffer_bytes)
+    : queue(queue_capacity),
+      buffer(new OutputBuffer(target, buffer_bytes > 0 ? buffer_bytes : 1)),
+      out(buffer.get()) {
+    writer = std::thread(&AsyncWriter::writerLoop, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    job_ready.notify_all();
+    writer.join();
+    out.flush();
+    buffer.reset();   // ожидает запись последнего буфера
+}
+
+void AsyncWriter::submit(Job job) {
+    submitted.fetch_add(1);
+    if (!queue.tryPush(std::move(job))) {
+        // Очередь заполнена: ждём, пока поток записи заберёт задание
+        stall_count.fetch_add(1);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!queue.tryPush(std::move(job))) {
+            job_taken.wait(lock);
+        }
+    }
+    // Пара к проверке очереди после writer_sleeping = true в writerLoop
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writer_sleeping.load()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        job_ready.notify_one();
+    }
+}
+
+void AsyncWriter::flush() {
+    // Задание-маркер передаёт заполненную часть буфера в target
+    submit([](std::ostream& stream) { stream.flush(); });
+    const unsigned long long target_count = submitted.load();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        job_taken.wait(lock, [&]() { return completed.load() >= target_count; });
+    }
+    buffer->waitIdle();
+}
+
+void AsyncWriter::writerLoop() {
+    Job job;
+    for (;;) {
+        if (!queue.tryPop(job)) {
+            std::unique_lock<std::mutex> lock(mutex);
+            writer_sleeping.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            // Проверка под мьютексом: уведомление submit не может потеряться
+            if (!queue.tryPop(job)) {
+                if (stopping) {
+                    writer_sleeping.store(false);
+                    return;
+                }
+                job_ready.wait(lock);
+                writer_sleeping.store(false);
+                continue;
+            }
+            writer_sleeping.store(false);
+        }
+
+        try {
+            job(out);
+        } catch (const std::exception& e) {
+            out.flush();
+            std::cerr << "Ошибка вывода: " << e.what() << std::endl;
+        }
+        job = Job();
+
+        completed.fetch_add(1);
+        // Место в очереди освободилось; flush ждёт выполнения
+        std::lock_guard<std::mutex> lock(mutex);
+        job_taken.notify_all();
+    }
+}
@@ -0,0 +1,156 @@
+#include "atmosphere_profile.h"
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+
+namespace {
+
+// Константы те же, что в atmosphere.cpp
+const double R = 287.05287;        // Газовая постоянная для воздуха, Дж/(кг·К)
+const double G0 = 9.80665;         // Ускорение свободного падения на уровне моря, м/с²
+const double R_EARTH = 6356767.0;  // Радиус Земли, м
+
+// Наибольшее число корзин равномерного индекса (1 МиБ на индекс)
+const size_t MAX_BUCKETS = 1u << 18;
+
+} // namespace
+
+AtmosphereProfile::AtmosphereProfile(const std::vector<double>& altitude, const std::vector<double>& T,
+                                     const std::vector<double>& p, const std::vector<double>& wind) {
+    const size_t n = altitude.size();
+    if (n < 2 || T.size() != n || p.size() != n || (!wind.empty() && wind.size() != n)) {
+        throw std::runtime_error("Профиль атмосферы: нужно не менее двух уровней с T и p");
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (T[i] <= 0.0 || p[i] <= 0.0) {
+            throw std::runtime_error("Профиль атмосферы: T и p должны быть положительными");
+        }
+        if (i > 0 && altitude[i] <= altitude[i - 1]) {
+            throw std::runtime_error("Профиль атмосферы: высоты должны строго возрастать");
+        }
+    }
+
+    has_wind = !wind.empty();
+    levels_min = altitude.front();
+    levels_max = altitude.back();
+
+    segments.resize(n - 1);
+    double min_dh = levels_max - levels_min;
+    for (size_t i = 0; i + 1 < n; ++i) {
+        double dh = altitude[i + 1] - altitude[i];
+        min_dh = std::min(min_dh, dh);
+        Segment& s = segments[i];
+        s.h0 = altitude[i];
+        s.T0 = T[i];
+        s.dT = (T[i + 1] - T[i]) / dh;
+        s.lnp0 = std::log(p[i]);
+        s.dlnp = (std::log(p[i + 1]) - s.lnp0) / dh;
+        s.w0 = has_wind ? wind[i] : 0.0;
+        s.dw = has_wind ? (wind[i + 1] - wind[i]) / dh : 0.0;
+    }
+
+    // Равномерный индекс: корзина -> слой, содержащий её начало. Корзина не шире
+    // самого тонкого слоя, поэтому при равномерном профиле в ней не больше двух слоёв
+    double range = levels_max - levels_min;
+    double wanted = std::min(std::ceil(range / min_dh), static_cast<double>(MAX_BUCKETS));
+    size_t buckets = std::max(segments.size(), static_cast<size_t>(wanted));
+    double width = range / static_cast<double>(buckets);
+    bucket_inv_width = 1.0 / width;
+    bucket_segment.resize(buckets + 1);
+    size_t segment = 0;
+    for (size_t b = 0; b < buckets; ++b) {
+        double start = levels_min + static_cast<double>(b) * width;
+        while (segment + 1 < segments.size() && start >= segments[segment + 1].h0) {
+            ++segment;
+        }
+        bucket_segment[b] = static_cast<unsigned>(segment);
+    }
+    bucket_segment[buckets] = static_cast<unsigned>(segments.size() - 1);
+}
+
+std::shared_ptr<const AtmosphereProfile> AtmosphereProfile::load(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Ошибка открытия файла профиля атмосферы: " + filename);
+    }
+
+    std::vector<double> altitude, T, p, wind;
+    bool with_wind = false;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        std::istringstream in(line);
+        double h, t, pressure, w;
+        if (!(in >> h >> t >> pressure)) {
+            throw std::runtime_error("Ошибка разбора " + filename + ", строка " + std::to_string(line_number));
+        }
+        bool has_w = static_cast<bool>(in >> w);
+        if (altitude.empty()) {
+            with_wind = has_w;
+        } else if (has_w != with_wind) {
+            throw std::runtime_error("Профиль атмосферы " + filename + ": ветер задан не на всех уровнях");
+        }
+
+        altitude.push_back(h);
+        T.push_back(t);
+        p.push_back(pressure);
+        if (with_wind) wind.push_back(w);
+    }
+
+    return std::make_shared<const AtmosphereProfile>(altitude, T, p, wind);
+}
+
+size_t AtmosphereProfile::findSegment(double altitude) const {
+    size_t bucket = static_cast<size_t>((altitude - levels_min) * bucket_inv_width);
+    if (bucket + 1 >= bucket_segment.size()) bucket = bucket_segment.size() - 2;
+
+    // Слои корзины - [first, last]; ищется последний слой с h0 < altitude
+    size_t first = bucket_segment[bucket];
+    size_t last = bucket_segment[bucket + 1];
+    while (first < last) {
+        size_t middle = first + (last - first + 1) / 2;
+        if (altitude > segments[middle].h0) {
+            first = middle;
+        } else {
+            last = middle - 1;
+        }
+    }
+    return first;
+}
+
+AtmosphereParams AtmosphereProfile::evaluate(double altitude, double* wind) const {
+    if (altitude < levels_min || altitude > levels_max) {
+        if (wind != nullptr) *wind = 0.0;
+        return calculate_atmosphere(altitude);
+    }
+
+    const Segment& s = segments[findSegment(altitude)];
+    double dh = altitude - s.h0;
+
+    AtmosphereParams result;
+    result.H_geom = altitude;
+    result.H_geo = (R_EARTH * altitude) / (R_EARTH + altitude);
+    double ratio = R_EARTH / (R_EARTH + altitude);
+    result.g = G0 * ratio * ratio;
+    result.T = s.T0 + s.dT * dh;
+    result.p = std::exp(s.lnp0 + s.dlnp * dh);
+    result.ro = result.p / (R * result.T);
+    result.a = 20.046796 * std::sqrt(result.T);
+
+    if (wind != nullptr) *wind = s.w0 + s.dw * dh;
+    return result;
+}
+
+void AtmosphereProfile::appendContent(std::string& out) const {
+    const std::uint64_t count = segments.size();
+    out.append(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.append(reinterpret_cast<const char*>(segments.data()), segments.size() * sizeof(Segment));
+    out.append(reinterpret_cast<const char*>(&levels_max), sizeof(levels_max));
+}
@@ -0,0 +1,434 @@
+#include "batch.h"
+#include "checkpoint.h"
+#include "trajectory_arena.h"
+#include "result_cache.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+
+namespace {
+
+// Слот рабочего потока: последний опубликованный снимок незавершённого случая
+struct WorkerSlot {
+    std::mutex mutex;
+    bool busy = false;                        // поток рассчитывает случай
+    bool active = false;                      // snapshot относится к этому случаю
+    unsigned long long published_epoch = 0;   // эпоха последнего снимка
+    CaseSnapshot snapshot;
+};
+
+} // namespace
+
+const char* methodName(IntegrationMethod method) {
+    switch (method) {
+        case EULER: return "EULER";
+        case MODIFIED_EULER: return "MODIFIED_EULER";
+        case RUNGE_KUTTA_4: return "RUNGE_KUTTA_4";
+        case ROSENBROCK: return "ROSENBROCK";
+    }
+    return "RUNGE_KUTTA_4";
+}
+
+const char* alphaLawName(AlphaLaw alpha_law) {
+    return alpha_law == ALPHA_ZERO ? "ZERO" : "THETA";
+}
+
+bool parseMethod(const std::string& name, IntegrationMethod& method) {
+    if (name == "EULER") method = EULER;
+    else if (name == "MODIFIED_EULER") method = MODIFIED_EULER;
+    else if (name == "RUNGE_KUTTA_4") method = RUNGE_KUTTA_4;
+    else if (name == "ROSENBROCK") method = ROSENBROCK;
+    else return false;
+    return true;
+}
+
+bool parseAlphaLaw(const std::string& name, AlphaLaw& alpha_law) {
+    if (name == "THETA") alpha_law = ALPHA_THETA_MINUS_THETAC;
+    else if (name == "ZERO") alpha_law = ALPHA_ZERO;
+    else return false;
+    return true;
+}
+
+namespace {
+
+const char* const VEHICLE_FIELD_NAMES[VEHICLE_FIELD_COUNT] = {
+    "V0", "theta_c0", "m_dot", "W", "y0", "omega_z0", "theta0", "t_end", "m0", "I_d", "S_a", "S_m"
+};
+
+double VehicleParams::* const VEHICLE_FIELDS[VEHICLE_FIELD_COUNT] = {
+    &VehicleParams::V0, &VehicleParams::theta_c0, &VehicleParams::m_dot, &VehicleParams::W,
+    &VehicleParams::y0, &VehicleParams::omega_z0, &VehicleParams::theta0, &VehicleParams::t_end,
+    &VehicleParams::m0, &VehicleParams::I_d, &VehicleParams::S_a, &VehicleParams::S_m
+};
+
+} // namespace
+
+const char* vehicleFieldName(size_t index) {
+    return index < VEHICLE_FIELD_COUNT ? VEHICLE_FIELD_NAMES[index] : "";
+}
+
+size_t vehicleFieldIndex(const std::string& name) {
+    size_t index = 0;
+    while (index < VEHICLE_FIELD_COUNT && name != VEHICLE_FIELD_NAMES[index]) ++index;
+    return index;
+}
+
+double& vehicleField(VehicleParams& params, size_t index) {
+    return params.*VEHICLE_FIELDS[index];
+}
+
+double vehicleField(const VehicleParams& params, size_t index) {
+    return params.*VEHICLE_FIELDS[index];
+}
+
+bool parseBatchCase(const std::string& line, BatchCase& result) {
+    std::istringstream in(line);
+    VehicleParams& p = result.params;
+    std::string method, alpha_law;
+    if (!(in >> result.name >> p.V0 >> p.theta_c0 >> p.m_dot >> p.W >> p.y0 >> p.omega_z0
+             >> p.theta0 >> p.t_end >> p.m0 >> p.I_d >> p.S_a >> p.S_m
+             >> method >> alpha_law >> result.dt)) {
+        return false;
+    }
+    return parseMethod(method, result.method) && parseAlphaLaw(alpha_law, result.alpha_law)
+           && result.dt > 0.0;
+}
+
+std::string formatBatchCase(const BatchCase& c) {
+    const VehicleParams& p = c.params;
+    std::ostringstream out;
+    // 17 значащих цифр - точное восстановление double при разборе
+    out << std::setprecision(17) << c.name << ' '
+        << p.V0 << ' ' << p.theta_c0 << ' ' << p.m_dot << ' ' << p.W << ' '
+        << p.y0 << ' ' << p.omega_z0 << ' ' << p.theta0 << ' ' << p.t_end << ' '
+        << p.m0 << ' ' << p.I_d << ' ' << p.S_a << ' ' << p.S_m << ' '
+        << methodName(c.method) << ' ' << alphaLawName(c.alpha_law) << ' ' << c.dt;
+    return out.str();
+}
+
+std::vector<BatchCase> loadBatchCases(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Ошибка открытия файла случаев: " + filename);
+    }
+
+    std::vector<BatchCase> cases;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        BatchCase batch_case;
+        if (!parseBatchCase(line, batch_case)) {
+            throw std::runtime_error("Ошибка разбора " + filename + ", строка " +
+                                     std::to_string(line_number));
+        }
+        cases.push_back(batch_case);
+    }
+    return cases;
+}
+
+namespace {
+
+const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+
+unsigned long long fnv1a(unsigned long long hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+unsigned long long batchFingerprint(const std::vector<BatchCase>& cases) {
+    // FNV-1a по текстовому представлению случаев
+    unsigned long long hash = FNV_OFFSET;
+    for (const BatchCase& c : cases) {
+        std::string line = formatBatchCase(c);
+        line += '\n';
+        hash = fnv1a(hash, line.data(), line.size());
+    }
+    return hash;
+}
+
+unsigned long long batchOptionsFingerprint(const BatchOptions& options) {
+    // Модели - по содержимому, с длиной перед каждой частью
+    std::string content;
+    unsigned long long hash = FNV_OFFSET;
+    if (options.atmosphere) options.atmosphere->appendContent(content);
+    std::uint64_t size = content.size();
+    hash = fnv1a(hash, &size, sizeof(size));
+    hash = fnv1a(hash, content.data(), content.size());
+    content.clear();
+    if (options.aero) options.aero->appendContent(content);
+    size = content.size();
+    hash = fnv1a(hash, &size, sizeof(size));
+    hash = fnv1a(hash, content.data(), content.size());
+
+    const unsigned char pitch = options.pitch.enabled ? 1 : 0;
+    hash = fnv1a(hash, &pitch, sizeof(pitch));
+    if (options.pitch.enabled) {
+        hash = fnv1a(hash, &options.pitch.I_z0, sizeof(double));
+        hash = fnv1a(hash, &options.pitch.L, sizeof(double));
+        hash = fnv1a(hash, &options.pitch.mz_omegaz, sizeof(double));
+    }
+    const unsigned char fast = options.fast_math ? 1 : 0;
+    return fnv1a(hash, &fast, sizeof(fast));
+}
+
+size_t runBatch(const std::vector<BatchCase>& cases, const BatchOptions& options,
+                const BatchCallback& on_complete) {
+    unsigned threads = options.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const bool checkpointing = !options.checkpoint_file.empty();
+    // Контрольная точка другой модели (атмосфера, аэродинамика, тангаж, физика) не используется
+    const unsigned long long options_fingerprint = batchOptionsFingerprint(options);
+    const unsigned long long fingerprint =
+        fnv1a(batchFingerprint(cases), &options_fingerprint, sizeof(options_fingerprint));
+
+    std::unique_ptr<std::atomic<unsigned char>[]> done(new std::atomic<unsigned char>[cases.size()]);
+    for (size_t i = 0; i < cases.size(); ++i) {
+        done[i].store(0);
+    }
+
+    // Продолжение с контрольной точки
+    std::map<size_t, CaseSnapshot> resumed;
+    if (checkpointing) {
+        BatchCheckpoint checkpoint;
+        if (loadBatchCheckpoint(options.checkpoint_file, checkpoint)) {
+            if (checkpoint.fingerprint == fingerprint && checkpoint.done.size() == cases.size()) {
+                for (size_t i = 0; i < cases.size(); ++i) {
+                    done[i].store(checkpoint.done[i]);
+                }
+                for (CaseSnapshot& snapshot : checkpoint.running) {
+                    if (!checkpoint.done[snapshot.index]) {
+                        resumed[snapshot.index] = std::move(snapshot);
+                    }
+                }
+                std::cout << "Продолжение с контрольной точки " << options.checkpoint_file << "\n";
+            } else {
+                std::cerr << "Контрольная точка " << options.checkpoint_file
+                          << " относится к другому списку случаев или модели и не используется\n";
+            }
+        }
+    }
+
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < cases.size(); ++i) {
+        if (!done[i].load()) pending.push_back(i);
+    }
+
+    std::vector<WorkerSlot> slots(threads);
+    std::atomic<size_t> next_case{0};
+    std::atomic<size_t> completed{0};
+    std::atomic<unsigned long long> epoch{0};
+
+    // Запись контрольной точки из опубликованных снимков
+    auto write_checkpoint = [&]() {
+        // Снимки читаются до флагов завершения: случай, завершившийся между
+        // этими чтениями, попадёт в файл как завершённый, а не как ожидающий
+        std::map<size_t, CaseSnapshot> latest = resumed;
+        for (WorkerSlot& slot : slots) {
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            if (slot.active) {
+                latest[slot.snapshot.index] = slot.snapshot;
+            }
+        }
+
+        BatchCheckpoint checkpoint;
+        checkpoint.fingerprint = fingerprint;
+        checkpoint.done.resize(cases.size());
+        for (size_t i = 0; i < cases.size(); ++i) {
+            checkpoint.done[i] = done[i].load();
+        }
+        for (auto& item : latest) {
+            if (!checkpoint.done[item.first]) {
+                checkpoint.running.push_back(std::move(item.second));
+            }
+        }
+        if (!saveBatchCheckpoint(options.checkpoint_file, checkpoint)) {
+            std::cerr << "Ошибка записи контрольной точки: " << options.checkpoint_file << "\n";
+        }
+    };
+
+    // Рабочие потоки сообщают о публикации снимка и о завершении случая
+    std::mutex publish_mutex;
+    std::condition_variable publish_cv;
+    auto notify_published = [&]() {
+        std::lock_guard<std::mutex> lock(publish_mutex);
+        publish_cv.notify_all();
+    };
+    // Все рассчитываемые случаи опубликовали снимок эпохи current_epoch
+    auto all_published = [&](unsigned long long current_epoch) {
+        for (WorkerSlot& slot : slots) {
+            std::lock_guard<std::mutex> lock(slot.mutex);
+            if (slot.busy && slot.published_epoch != current_epoch) return false;
+        }
+        return true;
+    };
+
+    std::mutex timer_mutex;
+    std::condition_variable timer_cv;
+    bool stop_timer = false;
+    std::thread checkpointer;
+    if (checkpointing) {
+        checkpointer = std::thread([&]() {
+            std::unique_lock<std::mutex> lock(timer_mutex);
+            auto period = std::chrono::duration<double>(options.checkpoint_period);
+            while (!timer_cv.wait_for(lock, period, [&]() { return stop_timer; })) {
+                // Новая эпоха - рабочие потоки публикуют снимки на ближайшей проверке;
+                // файл пишется после публикации всеми (не дольше периода), поэтому
+                // при сбое теряется не больше одного периода расчёта
+                const unsigned long long current_epoch = epoch.fetch_add(1) + 1;
+                lock.unlock();
+                {
+                    std::unique_lock<std::mutex> publish_lock(publish_mutex);
+                    publish_cv.wait_for(publish_lock, period, [&]() { return all_published(current_epoch); });
+                }
+                write_checkpoint();
+                lock.lock();
+            }
+        });
+    }
+
+    // Отпечаток модели для ключей кэша - один раз на пакет
+    const ResultKey cache_model = options.cache ? ResultCache::modelDigest(options) : ResultKey{0, 0};
+
+    // Буфер траектории на рабочий поток, переиспользуется от случая к случаю
+    TrajectoryArena arena(threads);
+
+    auto worker = [&](unsigned w) {
+        WorkerSlot& slot = slots[w];
+        size_t k;
+        while ((k = next_case.fetch_add(1)) < pending.size()) {
+            const size_t index = pending[k];
+            const BatchCase& batch_case = cases[index];
+
+            // Ошибка подготовки, расчёта или обработки результата завершает случай
+            // как неудачный (пустая траектория), а не весь пакет
+            bool reported = false;   // on_complete уже вызван
+            bool cached = false;     // результат из кэша, случай не рассчитывался
+            try {
+                TrajectoryCalculator calculator(batch_case.params);
+                calculator.setAtmosphereProfile(options.atmosphere);
+                calculator.setAeroDatabase(options.aero);
+                calculator.setPitchDynamics(options.pitch);
+                calculator.setFastMath(options.fast_math);
+
+                std::vector<TrajectoryPoint>& trajectory =
+                    arena.acquire(w, calculator.expectedPointCount(batch_case.dt));
+                IntegratorState state;
+                auto it = resumed.find(index);
+
+                // Случай из кэша результатов не рассчитывается
+                ResultKey cache_key = {0, 0};
+                if (options.cache) {
+                    cache_key = ResultCache::key(batch_case, cache_model);
+                    cached = it == resumed.end() &&
+                             options.cache->lookup(cache_key, trajectory, options.end_state_only);
+                }
+
+                if (!cached) {
+                    if (it != resumed.end()) {
+                        state = it->second.state;
+                        trajectory.assign(it->second.trajectory.begin(), it->second.trajectory.end());
+                    } else {
+                        state = calculator.initialState(batch_case.method, batch_case.alpha_law, batch_case.dt);
+                    }
+
+                    // Новый случай публикует снимок на первой проверке, дальше - раз в эпоху
+                    unsigned long long seen_epoch = ~0ULL;
+                    CheckpointHook hook;
+                    hook.interval = options.snapshot_interval;
+                    hook.callback = [&](const IntegratorState& current, const std::vector<TrajectoryPoint>& points) {
+                        unsigned long long current_epoch = epoch.load(std::memory_order_relaxed);
+                        if (current_epoch == seen_epoch) return;
+                        {
+                            std::lock_guard<std::mutex> lock(slot.mutex);
+                            slot.active = true;
+                            slot.published_epoch = current_epoch;
+                            slot.snapshot.index = index;
+                            slot.snapshot.state = current;
+                            slot.snapshot.trajectory = points;
+                        }
+                        seen_epoch = current_epoch;
+                        notify_published();
+                    };
+                    if (checkpointing) {
+                        std::lock_guard<std::mutex> lock(slot.mutex);
+                        slot.busy = true;
+                    }
+
+                    calculator.continueTrajectory(state, trajectory, checkpointing ? &hook : nullptr);
+                    if (options.cache) {
+                        options.cache->store(cache_key, trajectory);
+                    }
+                }
+
+                reported = true;
+                on_complete(w, index, trajectory);
+            } catch (const std::exception& e) {
+                std::cerr << "Ошибка при расчёте случая " << batch_case.name << ": " << e.what() << std::endl;
+            }
+            if (!reported) {
+                try {
+                    on_complete(w, index, std::vector<TrajectoryPoint>());
+                } catch (const std::exception& e) {
+                    std::cerr << "Ошибка при обработке случая " << batch_case.name << ": " << e.what() << std::endl;
+                }
+            }
+
+            done[index].store(1);
+            {
+                std::lock_guard<std::mutex> lock(slot.mutex);
+                slot.busy = false;
+                slot.active = false;
+            }
+            if (checkpointing) notify_published();
+            if (!cached) completed.fetch_add(1);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned w = 1; w < threads; ++w) {
+        pool.emplace_back(worker, w);
+    }
+    worker(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    if (checkpointing) {
+        {
+            std::lock_guard<std::mutex> lock(timer_mutex);
+            stop_timer = true;
+        }
+        timer_cv.notify_all();
+        checkpointer.join();
+        std::remove(options.checkpoint_file.c_str());
+    }
+    if (options.cache) {
+        options.cache->trim();
+    }
+
+    return completed.load();
+}
@@ -0,0 +1,132 @@
+#include "checkpoint.h"
+#include <fstream>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <system_error>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+const char CHECKPOINT_MAGIC[8] = {'B', 'A', 'L', 'C', 'K', 'P', 'T', '1'};
+
+// Ограничение на размеры при чтении (защита от повреждённого файла)
+const std::uint64_t MAX_RECORDS = 1ULL << 32;
+
+template <typename T>
+void write_raw(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool read_raw(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+} // namespace
+
+void writeIntegratorState(std::ostream& out, const IntegratorState& state) {
+    write_raw(out, state.t);
+    for (double v : state.state) {
+        write_raw(out, v);
+    }
+    write_raw(out, static_cast<std::int32_t>(state.method));
+    write_raw(out, static_cast<std::int32_t>(state.alpha_law));
+    write_raw(out, state.dt);
+    write_raw(out, static_cast<std::uint64_t>(state.steps));
+}
+
+bool readIntegratorState(std::istream& in, IntegratorState& state) {
+    std::int32_t method = 0, alpha_law = 0;
+    std::uint64_t steps = 0;
+    bool ok = read_raw(in, state.t);
+    for (double& v : state.state) {
+        ok = ok && read_raw(in, v);
+    }
+    ok = ok && read_raw(in, method) && read_raw(in, alpha_law)
+            && read_raw(in, state.dt) && read_raw(in, steps);
+    state.method = static_cast<IntegrationMethod>(method);
+    state.alpha_law = static_cast<AlphaLaw>(alpha_law);
+    state.steps = steps;
+    return ok;
+}
+
+bool saveBatchCheckpoint(const std::string& filename, const BatchCheckpoint& checkpoint) {
+    std::string tmp_name = filename + ".tmp";
+    {
+        std::ofstream file(tmp_name, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        file.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+        write_raw(file, static_cast<std::uint64_t>(checkpoint.fingerprint));
+        write_raw(file, static_cast<std::uint64_t>(checkpoint.done.size()));
+        file.write(reinterpret_cast<const char*>(checkpoint.done.data()),
+                   static_cast<std::streamsize>(checkpoint.done.size()));
+
+        write_raw(file, static_cast<std::uint64_t>(checkpoint.running.size()));
+        for (const CaseSnapshot& snapshot : checkpoint.running) {
+            write_raw(file, static_cast<std::uint64_t>(snapshot.index));
+            writeIntegratorState(file, snapshot.state);
+            write_raw(file, static_cast<std::uint64_t>(snapshot.trajectory.size()));
+            file.write(reinterpret_cast<const char*>(snapshot.trajectory.data()),
+                       static_cast<std::streamsize>(snapshot.trajectory.size() * sizeof(TrajectoryPoint)));
+        }
+
+        file.flush();
+        if (!file) {
+            return false;
+        }
+    }
+    // std::filesystem::rename заменяет существующий файл и в Windows (std::rename - нет)
+    std::error_code error;
+    std::filesystem::rename(tmp_name, filename, error);
+    return !error;
+}
+
+bool loadBatchCheckpoint(const std::string& filename, BatchCheckpoint& checkpoint) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    char magic[sizeof(CHECKPOINT_MAGIC)];
+    if (!file.read(magic, sizeof(magic)) ||
+        !std::equal(magic, magic + sizeof(magic), CHECKPOINT_MAGIC)) {
+        return false;
+    }
+
+    std::uint64_t fingerprint = 0, case_count = 0, running_count = 0;
+    if (!read_raw(file, fingerprint) || !read_raw(file, case_count) || case_count > MAX_RECORDS) {
+        return false;
+    }
+    checkpoint.fingerprint = fingerprint;
+    checkpoint.done.assign(case_count, 0);
+    if (!file.read(reinterpret_cast<char*>(checkpoint.done.data()), static_cast<std::streamsize>(case_count))) {
+        return false;
+    }
+
+    if (!read_raw(file, running_count) || running_count > case_count) {
+        return false;
+    }
+    checkpoint.running.clear();
+    for (std::uint64_t i = 0; i < running_count; ++i) {
+        CaseSnapshot snapshot;
+        std::uint64_t index = 0, points = 0;
+        if (!read_raw(file, index) || index >= case_count ||
+            !readIntegratorState(file, snapshot.state) ||
+            !read_raw(file, points) || points > MAX_RECORDS) {
+            return false;
+        }
+        snapshot.index = static_cast<size_t>(index);
+        snapshot.trajectory.resize(points);
+        if (!file.read(reinterpret_cast<char*>(snapshot.trajectory.data()),
+                       static_cast<std::streamsize>(points * sizeof(TrajectoryPoint)))) {
+            return false;
+        }
+        checkpoint.running.push_back(std::move(snapshot));
+    }
+    return true;
+}
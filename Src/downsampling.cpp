@@ -0,0 +1,105 @@
+#include "downsampling.h"
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// Все поля точки траектории (для линейного восстановления)
+double TrajectoryPoint::* const POINT_FIELDS[] = {
+    &TrajectoryPoint::t, &TrajectoryPoint::V, &TrajectoryPoint::theta_c,
+    &TrajectoryPoint::x, &TrajectoryPoint::y, &TrajectoryPoint::omega_z,
+    &TrajectoryPoint::theta, &TrajectoryPoint::m, &TrajectoryPoint::P,
+    &TrajectoryPoint::g, &TrajectoryPoint::M, &TrajectoryPoint::Cxa,
+    &TrajectoryPoint::Cya_alpha, &TrajectoryPoint::alpha, &TrajectoryPoint::x_dotc,
+    &TrajectoryPoint::y_dotc, &TrajectoryPoint::V_dot
+};
+
+// Доля положения t на отрезке [t_a, t_b]
+double segment_fraction(double t, double t_a, double t_b) {
+    double span = t_b - t_a;
+    return span > 0.0 ? (t - t_a) / span : 0.0;
+}
+
+// Нормированное отклонение: > 1 означает превышение допуска
+double normalized_error(double error, double tolerance) {
+    if (tolerance > 0.0) return error / tolerance;
+    return error > 0.0 ? HUGE_VAL : 0.0;
+}
+
+} // namespace
+
+std::vector<size_t> downsampleIndices(const std::vector<const TrajectoryPoint*>& points,
+                                      const DownsampleTolerance& tolerance) {
+    std::vector<size_t> kept;
+    const size_t n = points.size();
+    if (n <= 2) {
+        for (size_t i = 0; i < n; ++i) kept.push_back(i);
+        return kept;
+    }
+
+    std::vector<char> keep(n, 0);
+    keep[0] = keep[n - 1] = 1;
+
+    // Рекурсия Дугласа–Пекера на явном стеке отрезков
+    std::vector<std::pair<size_t, size_t>> segments;
+    segments.push_back({0, n - 1});
+
+    while (!segments.empty()) {
+        size_t a = segments.back().first;
+        size_t b = segments.back().second;
+        segments.pop_back();
+        if (b - a < 2) continue;
+
+        const TrajectoryPoint& pa = *points[a];
+        const TrajectoryPoint& pb = *points[b];
+
+        size_t worst = a;
+        double worst_error = 1.0;
+        for (size_t i = a + 1; i < b; ++i) {
+            const TrajectoryPoint& p = *points[i];
+            double s = segment_fraction(p.t, pa.t, pb.t);
+            double ex = std::abs(p.x - (pa.x + s * (pb.x - pa.x)));
+            double ey = std::abs(p.y - (pa.y + s * (pb.y - pa.y)));
+            double eV = std::abs(p.V - (pa.V + s * (pb.V - pa.V)));
+            double error = std::max(normalized_error(ex, tolerance.x),
+                           std::max(normalized_error(ey, tolerance.y),
+                                    normalized_error(eV, tolerance.V)));
+            if (error > worst_error) {
+                worst_error = error;
+                worst = i;
+            }
+        }
+
+        if (worst != a) {
+            keep[worst] = 1;
+            segments.push_back({a, worst});
+            segments.push_back({worst, b});
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        if (keep[i]) kept.push_back(i);
+    }
+    return kept;
+}
+
+TrajectoryPoint interpolateTrajectory(const std::vector<TrajectoryPoint>& reduced, double t) {
+    if (reduced.empty()) return TrajectoryPoint();
+    if (t <= reduced.front().t) return reduced.front();
+    if (t >= reduced.back().t) return reduced.back();
+
+    // Первая точка с временем больше t
+    auto upper = std::upper_bound(reduced.begin(), reduced.end(), t,
+                                  [](double value, const TrajectoryPoint& p) { return value < p.t; });
+    const TrajectoryPoint& pb = *upper;
+    const TrajectoryPoint& pa = *(upper - 1);
+    double s = segment_fraction(t, pa.t, pb.t);
+
+    TrajectoryPoint point;
+    for (auto field : POINT_FIELDS) {
+        point.*field = pa.*field + s * (pb.*field - pa.*field);
+    }
+    point.t = t;
+    return point;
+}
@@ -0,0 +1,499 @@
+#include "ensemble_stats.h"
+#include "downsampling.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+const char* const VARIABLE_NAMES[ENSEMBLE_VARIABLE_COUNT] = {
+    "t", "V", "theta_c", "x", "y", "omega_z", "theta", "m"
+};
+
+double TrajectoryPoint::* const VARIABLE_FIELDS[ENSEMBLE_VARIABLE_COUNT] = {
+    &TrajectoryPoint::t, &TrajectoryPoint::V, &TrajectoryPoint::theta_c, &TrajectoryPoint::x,
+    &TrajectoryPoint::y, &TrajectoryPoint::omega_z, &TrajectoryPoint::theta, &TrajectoryPoint::m
+};
+
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+// Целое без знака по 32 бита от младшего разряда
+typedef std::vector<std::uint32_t> Magnitude;
+
+void trim(Magnitude& a) {
+    while (!a.empty() && a.back() == 0) a.pop_back();
+}
+
+int compare(const Magnitude& a, const Magnitude& b) {
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+Magnitude multiply(const Magnitude& a, const Magnitude& b) {
+    Magnitude result(a.size() + b.size(), 0);
+    for (size_t i = 0; i < a.size(); ++i) {
+        std::uint64_t carry = 0;
+        for (size_t j = 0; j < b.size(); ++j) {
+            std::uint64_t cur = static_cast<std::uint64_t>(a[i]) * b[j] + result[i + j] + carry;
+            result[i + j] = static_cast<std::uint32_t>(cur);
+            carry = cur >> 32;
+        }
+        result[i + b.size()] = static_cast<std::uint32_t>(carry);
+    }
+    trim(result);
+    return result;
+}
+
+// a - b при a >= b
+Magnitude subtract(const Magnitude& a, const Magnitude& b) {
+    Magnitude result(a);
+    std::int64_t borrow = 0;
+    for (size_t i = 0; i < result.size(); ++i) {
+        std::int64_t cur = static_cast<std::int64_t>(result[i]) - (i < b.size() ? b[i] : 0) - borrow;
+        borrow = cur < 0;
+        result[i] = static_cast<std::uint32_t>(cur + (borrow << 32));
+    }
+    trim(result);
+    return result;
+}
+
+Magnitude add(const Magnitude& a, const Magnitude& b) {
+    Magnitude result(std::max(a.size(), b.size()) + 1, 0);
+    std::uint64_t carry = 0;
+    for (size_t i = 0; i < result.size(); ++i) {
+        std::uint64_t cur = carry + (i < a.size() ? a[i] : 0) + (i < b.size() ? b[i] : 0);
+        result[i] = static_cast<std::uint32_t>(cur);
+        carry = cur >> 32;
+    }
+    trim(result);
+    return result;
+}
+
+// Знаковое целое: a_negative ? -a : a плюс b_negative ? -b : b
+bool signed_add(Magnitude& a, bool a_negative, const Magnitude& b, bool b_negative) {
+    if (a_negative == b_negative) {
+        a = add(a, b);
+        return a_negative;
+    }
+    if (compare(a, b) >= 0) {
+        a = subtract(a, b);
+        return a_negative;
+    }
+    a = subtract(b, a);
+    return b_negative;
+}
+
+Magnitude from_uint64(std::uint64_t value) {
+    Magnitude result = {static_cast<std::uint32_t>(value), static_cast<std::uint32_t>(value >> 32)};
+    trim(result);
+    return result;
+}
+
+// Округление magnitude * 2^exponent до double
+double to_double(const Magnitude& magnitude, bool negative, int exponent) {
+    if (magnitude.empty()) return 0.0;
+    auto bit = [&](long position) {
+        return position >= 0 && ((magnitude[position / 32] >> (position % 32)) & 1u);
+    };
+    long msb = static_cast<long>(magnitude.size()) * 32 - 1;
+    while (!bit(msb)) --msb;
+
+    // Старшие 64 бита; отброшенные ненулевые разряды - в младший бит,
+    // тогда преобразование в double округляет к ближайшему верно
+    const long lsb = msb - 63;
+    std::uint64_t bits = 0;
+    for (long position = msb; position >= lsb; --position) {
+        bits = (bits << 1) | (bit(position) ? 1u : 0u);
+    }
+    bool sticky = false;
+    for (long position = 0; position < lsb && !sticky; ++position) sticky = bit(position);
+    if (sticky) bits |= 1;
+    double value = std::ldexp(static_cast<double>(bits), exponent + static_cast<int>(lsb));
+    return negative ? -value : value;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------- ExactSum
+
+ExactSum::ExactSum() : pending(0), non_finite(false) {
+    std::fill(limbs, limbs + LIMBS, 0);
+}
+
+void ExactSum::add(double value) {
+    if (!std::isfinite(value)) {
+        non_finite = true;
+        return;
+    }
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const int biased = static_cast<int>((bits >> 52) & 0x7ff);
+    std::uint64_t mantissa = bits & ((1ULL << 52) - 1);
+    int exponent = -1074;
+    if (biased != 0) {
+        mantissa |= 1ULL << 52;
+        exponent = biased - 1075;
+    }
+    if (mantissa == 0) return;
+
+    // value = ±mantissa * 2^exponent; 53 бита попадают в три разряда
+    const int position = exponent - BASE_EXPONENT;
+    const int index = position / 32;
+    const int shift = position % 32;
+    const std::uint64_t low = mantissa << shift;
+    const std::uint64_t high = shift > 0 ? mantissa >> (64 - shift) : 0;
+    const std::int64_t sign = (bits >> 63) ? -1 : 1;
+    limbs[index] += sign * static_cast<std::int64_t>(low & 0xffffffffu);
+    limbs[index + 1] += sign * static_cast<std::int64_t>(low >> 32);
+    limbs[index + 2] += sign * static_cast<std::int64_t>(high);
+
+    // Разряд вмещает 2^31 слагаемых до переноса
+    if (++pending >= (1u << 30)) normalize();
+}
+
+void ExactSum::addProduct(double a, double b) {
+    const double product = a * b;
+    add(product);
+    add(std::fma(a, b, -product));
+}
+
+void ExactSum::normalize() {
+    for (int i = 0; i + 1 < LIMBS; ++i) {
+        std::int64_t carry = limbs[i] >> 32;   // с округлением вниз и для отрицательных
+        limbs[i] -= carry * (std::int64_t(1) << 32);
+        limbs[i + 1] += carry;
+    }
+    pending = 0;
+}
+
+void ExactSum::merge(const ExactSum& other) {
+    ExactSum normalized = other;
+    normalized.normalize();
+    normalize();
+    for (int i = 0; i < LIMBS; ++i) limbs[i] += normalized.limbs[i];
+    pending = 2;
+    non_finite = non_finite || other.non_finite;
+}
+
+bool ExactSum::magnitude(std::vector<std::uint32_t>& result) const {
+    ExactSum work = *this;
+    work.normalize();
+    const bool negative = work.limbs[LIMBS - 1] < 0;
+    if (negative) {
+        for (std::int64_t& limb : work.limbs) limb = -limb;
+        work.normalize();
+    }
+    result.assign(LIMBS, 0);
+    for (int i = 0; i < LIMBS; ++i) result[i] = static_cast<std::uint32_t>(work.limbs[i]);
+    trim(result);
+    return negative;
+}
+
+double ExactSum::value() const {
+    if (non_finite) return NaN;
+    Magnitude digits;
+    bool negative = magnitude(digits);
+    return to_double(digits, negative, BASE_EXPONENT);
+}
+
+// --------------------------------------------------------- EnsembleMoments
+
+EnsembleMoments::EnsembleMoments(size_t dims)
+    : dim_count(dims), n(0), sums(dims), products(dims * (dims + 1) / 2) {}
+
+void EnsembleMoments::add(const double* values) {
+    ++n;
+    size_t k = 0;
+    for (size_t i = 0; i < dim_count; ++i) {
+        sums[i].add(values[i]);
+        for (size_t j = i; j < dim_count; ++j) {
+            products[k++].addProduct(values[i], values[j]);
+        }
+    }
+}
+
+void EnsembleMoments::merge(const EnsembleMoments& other) {
+    if (other.dim_count != dim_count) {
+        throw std::invalid_argument("Объединение моментов разной размерности");
+    }
+    n += other.n;
+    for (size_t i = 0; i < sums.size(); ++i) sums[i].merge(other.sums[i]);
+    for (size_t k = 0; k < products.size(); ++k) products[k].merge(other.products[k]);
+}
+
+double EnsembleMoments::mean(size_t i) const {
+    if (n == 0) return NaN;
+    return sums[i].value() / static_cast<double>(n);
+}
+
+double EnsembleMoments::covariance(size_t i, size_t j) const {
+    if (n < 2) return NaN;
+    if (i > j) std::swap(i, j);
+    const ExactSum& product = products[i * dim_count - i * (i - 1) / 2 + (j - i)];
+    if (!sums[i].finite() || !sums[j].finite() || !product.finite()) return NaN;
+
+    // n * sum(x_i x_j) - sum(x_i) * sum(x_j) точно, в единицах 2^(2 * BASE_EXPONENT)
+    Magnitude si, sj, sp;
+    const bool si_negative = sums[i].magnitude(si);
+    const bool sj_negative = sums[j].magnitude(sj);
+    const bool sp_negative = product.magnitude(sp);
+    Magnitude scaled = multiply(sp, from_uint64(n));
+    if (!scaled.empty()) scaled.insert(scaled.begin(), -ExactSum::BASE_EXPONENT / 32, 0);
+    Magnitude cross = multiply(si, sj);
+    bool negative = signed_add(scaled, sp_negative, cross, si_negative == sj_negative);
+
+    const double d = to_double(scaled, negative, 2 * ExactSum::BASE_EXPONENT);
+    return d / (static_cast<double>(n) * static_cast<double>(n - 1));
+}
+
+// ---------------------------------------------------------- QuantileSketch
+
+QuantileSketch::QuantileSketch(double relative_accuracy)
+    : accuracy(relative_accuracy), zeros(0), nans(0), total(0),
+      minimum(std::numeric_limits<double>::infinity()),
+      maximum(-std::numeric_limits<double>::infinity()) {
+    if (!(relative_accuracy > 0.0 && relative_accuracy < 1.0)) {
+        throw std::invalid_argument("Точность квантилей должна быть в (0, 1)");
+    }
+    gamma = (1.0 + accuracy) / (1.0 - accuracy);
+    log_gamma = std::log(gamma);
+}
+
+int QuantileSketch::bucket(double magnitude) const {
+    return static_cast<int>(std::ceil(std::log(magnitude) / log_gamma));
+}
+
+double QuantileSketch::bucketValue(int index) const {
+    // Точка корзины (gamma^(i-1), gamma^i] с одинаковой относительной погрешностью до границ
+    return 2.0 * std::exp(index * log_gamma) / (gamma + 1.0);
+}
+
+void QuantileSketch::add(double value) {
+    if (!std::isfinite(value)) {
+        ++nans;
+        return;
+    }
+    ++total;
+    minimum = std::min(minimum, value);
+    maximum = std::max(maximum, value);
+    if (value > 0.0) ++positive[bucket(value)];
+    else if (value < 0.0) ++negative[bucket(-value)];
+    else ++zeros;
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (other.accuracy != accuracy) {
+        throw std::invalid_argument("Объединение скетчей разной точности");
+    }
+    for (const auto& item : other.positive) positive[item.first] += item.second;
+    for (const auto& item : other.negative) negative[item.first] += item.second;
+    zeros += other.zeros;
+    nans += other.nans;
+    total += other.total;
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+}
+
+double QuantileSketch::quantile(double q) const {
+    if (total == 0) return NaN;
+    q = std::min(1.0, std::max(0.0, q));
+    if (q == 0.0) return minimum;
+    if (q == 1.0) return maximum;
+
+    // Ранг от 0; корзины по возрастанию значений: отрицательные от больших модулей, нуль, положительные
+    const double rank = q * static_cast<double>(total - 1);
+    double value = maximum;
+    std::uint64_t seen = 0;
+    bool found = false;
+    for (auto it = negative.rbegin(); it != negative.rend() && !found; ++it) {
+        seen += it->second;
+        if (static_cast<double>(seen) > rank) {
+            value = -bucketValue(it->first);
+            found = true;
+        }
+    }
+    if (!found) {
+        seen += zeros;
+        if (static_cast<double>(seen) > rank) {
+            value = 0.0;
+            found = true;
+        }
+    }
+    for (auto it = positive.begin(); it != positive.end() && !found; ++it) {
+        seen += it->second;
+        if (static_cast<double>(seen) > rank) {
+            value = bucketValue(it->first);
+            found = true;
+        }
+    }
+    return std::min(maximum, std::max(minimum, value));
+}
+
+// --------------------------------------------------------------- Histogram
+
+Histogram::Histogram(double low, double high, size_t bins)
+    : low(low), high(high), counts(bins, 0), below(0), above(0), nans(0) {
+    if (bins == 0 || !(low < high) || !std::isfinite(low) || !std::isfinite(high)) {
+        throw std::invalid_argument("Гистограмма: нужны low < high и хотя бы один интервал");
+    }
+}
+
+void Histogram::add(double value) {
+    if (value != value) {
+        ++nans;
+    } else if (value < low) {
+        ++below;
+    } else if (value >= high) {
+        ++above;
+    } else {
+        size_t bin = static_cast<size_t>((value - low) / (high - low) * static_cast<double>(counts.size()));
+        ++counts[std::min(bin, counts.size() - 1)];
+    }
+}
+
+void Histogram::merge(const Histogram& other) {
+    if (other.low != low || other.high != high || other.counts.size() != counts.size()) {
+        throw std::invalid_argument("Объединение гистограмм с разными интервалами");
+    }
+    for (size_t i = 0; i < counts.size(); ++i) counts[i] += other.counts[i];
+    below += other.below;
+    above += other.above;
+    nans += other.nans;
+}
+
+// ----------------------------------------------------------- EnsembleStats
+
+const char* ensembleVariableName(size_t index) {
+    return index < ENSEMBLE_VARIABLE_COUNT ? VARIABLE_NAMES[index] : "";
+}
+
+size_t ensembleVariableIndex(const std::string& name) {
+    size_t index = 0;
+    while (index < ENSEMBLE_VARIABLE_COUNT && name != VARIABLE_NAMES[index]) ++index;
+    return index;
+}
+
+EnsembleStats::EnsembleStats(const EnsembleStatsOptions& options)
+    : options(options), run_count(0), failed(0) {
+    for (const HistogramSpec& spec : options.histograms) {
+        size_t variable = ensembleVariableIndex(spec.variable);
+        if (variable == ENSEMBLE_VARIABLE_COUNT) {
+            throw std::invalid_argument("Неизвестная величина гистограммы: " + spec.variable);
+        }
+        histogram_variables.push_back(variable);
+    }
+
+    Section section;
+    section.moments = EnsembleMoments(ENSEMBLE_VARIABLE_COUNT);
+    section.sketches.assign(ENSEMBLE_VARIABLE_COUNT, QuantileSketch(options.relative_accuracy));
+    for (const HistogramSpec& spec : options.histograms) {
+        section.histograms.emplace_back(spec.low, spec.high, spec.bins);
+    }
+    sections.assign(options.times.size() + 1, section);
+}
+
+void EnsembleStats::addState(Section& section, const TrajectoryPoint& point) {
+    double values[ENSEMBLE_VARIABLE_COUNT];
+    for (size_t i = 0; i < ENSEMBLE_VARIABLE_COUNT; ++i) {
+        values[i] = point.*VARIABLE_FIELDS[i];
+        section.sketches[i].add(values[i]);
+    }
+    section.moments.add(values);
+    for (size_t h = 0; h < section.histograms.size(); ++h) {
+        section.histograms[h].add(values[histogram_variables[h]]);
+    }
+}
+
+void EnsembleStats::add(const std::vector<TrajectoryPoint>& trajectory) {
+    ++run_count;
+    if (trajectory.empty()) {
+        ++failed;
+        return;
+    }
+    for (size_t k = 0; k < options.times.size(); ++k) {
+        if (options.times[k] > trajectory.back().t) {
+            ++sections[k].missing;
+            continue;
+        }
+        addState(sections[k], interpolateTrajectory(trajectory, options.times[k]));
+    }
+    addState(sections.back(), trajectory.back());
+}
+
+void EnsembleStats::merge(const EnsembleStats& other) {
+    if (other.options.times != options.times || other.sections.size() != sections.size()) {
+        throw std::invalid_argument("Объединение статистики с разными моментами времени");
+    }
+    run_count += other.run_count;
+    failed += other.failed;
+    for (size_t k = 0; k < sections.size(); ++k) {
+        Section& to = sections[k];
+        const Section& from = other.sections[k];
+        to.missing += from.missing;
+        to.moments.merge(from.moments);
+        for (size_t i = 0; i < to.sketches.size(); ++i) to.sketches[i].merge(from.sketches[i]);
+        if (from.histograms.size() != to.histograms.size()) {
+            throw std::invalid_argument("Объединение статистики с разными гистограммами");
+        }
+        for (size_t h = 0; h < to.histograms.size(); ++h) to.histograms[h].merge(from.histograms[h]);
+    }
+}
+
+void EnsembleStats::write(std::ostream& out) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::setprecision(10);
+    out << "runs\t" << run_count << "\nfailed\t" << failed << "\n"
+        << "# погрешность квантилей - доля accuracy от модуля значения\n"
+        << "accuracy\t" << options.relative_accuracy << "\n";
+
+    for (size_t k = 0; k < sections.size(); ++k) {
+        const Section& section = sections[k];
+        const bool end = k + 1 == sections.size();
+        out << "\n# " << (end ? std::string("end") : "t = " + std::to_string(options.times[k])) << "\n";
+        if (!end) out << "t\t" << options.times[k] << "\n";
+        out << "states\t" << section.moments.count() << "\nmissing\t" << section.missing << "\n";
+
+        out << "value\tmean\tstd\tmin";
+        for (double q : options.quantiles) out << "\tq" << q;
+        out << "\tmax\n";
+        for (size_t i = 0; i < ENSEMBLE_VARIABLE_COUNT; ++i) {
+            const QuantileSketch& sketch = section.sketches[i];
+            double variance = section.moments.covariance(i, i);
+            out << VARIABLE_NAMES[i] << "\t" << section.moments.mean(i) << "\t"
+                << (variance == variance ? std::sqrt(std::max(0.0, variance)) : NaN) << "\t"
+                << (sketch.count() > 0 ? sketch.min() : NaN);
+            for (double q : options.quantiles) out << "\t" << sketch.quantile(q);
+            out << "\t" << (sketch.count() > 0 ? sketch.max() : NaN) << "\n";
+        }
+
+        out << "covariance";
+        for (size_t j = 0; j < ENSEMBLE_VARIABLE_COUNT; ++j) out << "\t" << VARIABLE_NAMES[j];
+        out << "\n";
+        for (size_t i = 0; i < ENSEMBLE_VARIABLE_COUNT; ++i) {
+            out << VARIABLE_NAMES[i];
+            for (size_t j = 0; j < ENSEMBLE_VARIABLE_COUNT; ++j) out << "\t" << section.moments.covariance(i, j);
+            out << "\n";
+        }
+
+        for (size_t h = 0; h < section.histograms.size(); ++h) {
+            const Histogram& histogram = section.histograms[h];
+            out << "histogram\t" << VARIABLE_NAMES[histogram_variables[h]] << "\t" << histogram.low
+                << "\t" << histogram.high << "\t" << histogram.counts.size() << "\n"
+                << "below\t" << histogram.below << "\n";
+            const double width = (histogram.high - histogram.low) / static_cast<double>(histogram.counts.size());
+            for (size_t b = 0; b < histogram.counts.size(); ++b) {
+                out << histogram.low + width * static_cast<double>(b) << "\t" << histogram.counts[b] << "\n";
+            }
+            out << "above\t" << histogram.above << "\nnan\t" << histogram.nans << "\n";
+        }
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
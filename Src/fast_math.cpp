@@ -0,0 +1,130 @@
+#include "fast_math.h"
+#include "atmosphere.h"
+#include "trajectory.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Документированные допуски (fast_math.h)
+const double ATMOSPHERE_REL_BOUND = 1e-13;
+// Отклонение траектории: |быстрая - точная| / max(1, |точная|) по V, theta_c, x, y
+const double TRAJECTORY_REL_BOUND = 1e-10;
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double>(to - from).count();
+}
+
+// Название, дополненное пробелами до width символов (setw считает байты UTF-8)
+std::string padded(const std::string& text, size_t width) {
+    size_t chars = 0;
+    for (unsigned char c : text) chars += (c & 0xC0) != 0x80;
+    return chars < width ? text + std::string(width - chars, ' ') : text;
+}
+
+bool report(std::ostream& out, const std::string& what, double error, double bound) {
+    bool ok = error <= bound;
+    out << padded(what, 36) << std::scientific << std::setprecision(2)
+        << std::setw(12) << error << std::setw(12) << bound << "  " << (ok ? "в допуске" : "ПРЕВЫШЕНИЕ")
+        << "\n" << std::defaultfloat;
+    return ok;
+}
+
+double relative(double value, double reference) {
+    return std::fabs(value - reference) / std::fabs(reference);
+}
+
+// Случай траектории для сравнения; быстрый и точный расчёт с одним шагом
+struct CheckCase {
+    const char* name;
+    VehicleParams params;
+    double dt;
+};
+
+} // namespace
+
+bool fastMathSelfTest(std::ostream& out) {
+    std::mt19937_64 random(20241018);
+    const size_t count = 1 << 20;
+    bool ok = true;
+
+    out << padded("Величина", 36) << padded("      ошибка", 12) << padded("      допуск", 12) << "\n";
+
+    // Атмосфера: случайные высоты и границы слоёв; T, a, g должны совпадать
+    std::vector<double> altitude;
+    const double tops[] = {-2000.0, 0.0, 11000.0, 20000.0, 32000.0, 47000.0, 51000.0,
+                           71000.0, 85000.0, 94000.0};
+    for (double top : tops) {
+        altitude.push_back(top);
+        if (top > -2000.0) altitude.push_back(std::nextafter(top, -1e9));
+        if (top < 94000.0) altitude.push_back(std::nextafter(top, 1e9));
+    }
+    std::uniform_real_distribution<double> height(-2000.0, 94000.0);
+    while (altitude.size() < count) altitude.push_back(height(random));
+
+    double atmosphere_error = 0.0;
+    bool same_rest = true;
+    AtmosphereCursor exact_cursor = {0}, fast_cursor = {0};
+    for (double h : altitude) {
+        AtmosphereParams exact = calculate_atmosphere_cursor(h, &exact_cursor);
+        AtmosphereParams fast = calculate_atmosphere_fast(h, &fast_cursor);
+        atmosphere_error = std::max(atmosphere_error, relative(fast.p, exact.p));
+        atmosphere_error = std::max(atmosphere_error, relative(fast.ro, exact.ro));
+        same_rest = same_rest && fast.T == exact.T && fast.a == exact.a && fast.g == exact.g;
+    }
+    ok = report(out, "атмосфера p, ro, отн.", atmosphere_error, ATMOSPHERE_REL_BOUND) && ok;
+    out << "атмосфера T, a, g: " << (same_rest ? "совпадают" : "РАСХОЖДЕНИЕ") << "\n";
+    ok = ok && same_rest;
+
+    Clock::time_point t0 = Clock::now();
+    volatile double sink = 0.0;   // результат нужен, чтобы вызовы не были удалены
+    for (double h : altitude) sink += calculate_atmosphere_cursor(h, &exact_cursor).ro;
+    Clock::time_point t1 = Clock::now();
+    for (double h : altitude) sink += calculate_atmosphere_fast(h, &fast_cursor).ro;
+    Clock::time_point t2 = Clock::now();
+    out << std::fixed << std::setprecision(1) << "атмосфера, нс на вызов: точная "
+        << seconds(t0, t1) * 1e9 / count << ", быстрая " << seconds(t1, t2) * 1e9 / count
+        << "\n" << std::defaultfloat;
+
+    // Траектории: основной случай, подъём через границу тропосферы и полёт без тяги,
+    // где погрешность плотности сильнее всего сказывается на скорости
+    const CheckCase cases[] = {
+        {"основной", {70.5, 40.0, 86.0, 2245.0, 3401.0, 0.035, 40.0, 3.57, 1255.0, 0.215, 0.14, 0.231}, 1e-4},
+        {"через 11 км", {300.0, 60.0, 60.0, 2245.0, 9000.0, 0.0, 62.0, 12.0, 1255.0, 0.215, 0.14, 0.231}, 1e-3},
+        {"без тяги, 20-32 км", {900.0, 45.0, 0.0, 2245.0, 20000.0, 0.0, 45.0, 30.0, 300.0, 0.215, 0.14, 0.231}, 1e-3},
+    };
+    for (const CheckCase& c : cases) {
+        TrajectoryCalculator exact(c.params), fast(c.params);
+        fast.setFastMath(true);
+        std::vector<TrajectoryPoint> a, b;
+        Clock::time_point s0 = Clock::now();
+        exact.calculateTrajectory(RUNGE_KUTTA_4, ALPHA_THETA_MINUS_THETAC, c.dt, a);
+        Clock::time_point s1 = Clock::now();
+        fast.calculateTrajectory(RUNGE_KUTTA_4, ALPHA_THETA_MINUS_THETAC, c.dt, b);
+        Clock::time_point s2 = Clock::now();
+
+        double error = a.size() == b.size() && !a.empty() ? 0.0 : INFINITY;
+        for (size_t i = 0; i < a.size() && i < b.size(); ++i) {
+            const double pairs[4][2] = {{a[i].V, b[i].V}, {a[i].theta_c, b[i].theta_c},
+                                        {a[i].x, b[i].x}, {a[i].y, b[i].y}};
+            for (const auto& pair : pairs) {
+                error = std::max(error, std::fabs(pair[1] - pair[0]) / std::max(1.0, std::fabs(pair[0])));
+            }
+        }
+        std::string what = std::string("траектория \"") + c.name + "\", отн.";
+        ok = report(out, what, error, TRAJECTORY_REL_BOUND) && ok;
+        out << std::fixed << std::setprecision(1) << "  " << a.size() << " точек, мс: точная "
+            << seconds(s0, s1) * 1e3 << ", быстрая " << seconds(s1, s2) * 1e3 << "\n" << std::defaultfloat;
+    }
+
+    out << (ok ? "Быстрая физика в пределах допусков" : "Быстрая физика: ПРЕВЫШЕНИЕ допусков") << "\n";
+    return ok;
+}
@@ -0,0 +1,190 @@
+#include "kernels.h"
+#include "atmosphere.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+
+// Варианты ядер (Src/kernels_*.cpp)
+namespace kernels_generic { const KernelSet& kernel_set(); }
+#ifdef TRAJECTORY_ISA_VARIANTS
+namespace kernels_sse42 { const KernelSet& kernel_set(); }
+namespace kernels_avx2 { const KernelSet& kernel_set(); }
+namespace kernels_avx512 { const KernelSet& kernel_set(); }
+#endif
+
+// Поточечная интерполяция (trajectory.cpp) - эталон для ядра interpolate
+double interpolate_linear(double x, const std::vector<double>& x_vals, const std::vector<double>& y_vals);
+
+namespace {
+
+struct Variant {
+    const KernelSet& (*get)();
+    bool (*supported)();
+};
+
+bool always() { return true; }
+
+#ifdef TRAJECTORY_ISA_VARIANTS
+// __builtin_cpu_supports учитывает и поддержку регистров AVX операционной системой
+bool has_sse42() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+
+bool has_avx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+bool has_avx512() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")
+        && __builtin_cpu_supports("avx512vl");
+}
+#endif
+
+// От базового варианта к лучшему
+const Variant VARIANTS[] = {
+    {kernels_generic::kernel_set, always},
+#ifdef TRAJECTORY_ISA_VARIANTS
+    {kernels_sse42::kernel_set, has_sse42},
+    {kernels_avx2::kernel_set, has_avx2},
+    {kernels_avx512::kernel_set, has_avx512},
+#endif
+};
+
+std::atomic<const KernelSet*> active{nullptr};
+
+bool same_bits(const std::vector<double>& a, const std::vector<double>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+}
+
+} // namespace
+
+std::vector<const KernelSet*> availableKernels() {
+    std::vector<const KernelSet*> result;
+    for (const Variant& variant : VARIANTS) {
+        if (variant.supported()) result.push_back(&variant.get());
+    }
+    return result;
+}
+
+const KernelSet& kernels() {
+    const KernelSet* set = active.load(std::memory_order_acquire);
+    if (set == nullptr) {
+        set = availableKernels().back();
+        active.store(set, std::memory_order_release);
+    }
+    return *set;
+}
+
+bool selectKernels(const std::string& name) {
+    for (const KernelSet* set : availableKernels()) {
+        if (name == set->name) {
+            active.store(set, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool kernelSelfTest(std::ostream& out) {
+    typedef std::chrono::steady_clock Clock;
+    const size_t count = 1 << 20;
+    std::mt19937_64 random(20240611);
+
+    // Высоты: случайные в диапазоне и за ним, границы слоёв и соседние числа, особые значения
+    std::vector<double> altitude;
+    const double tops[] = {-2000.0, 0.0, 11000.0, 20000.0, 32000.0, 47000.0, 51000.0,
+                           71000.0, 85000.0, 94000.0};
+    for (double top : tops) {
+        altitude.push_back(top);
+        altitude.push_back(std::nextafter(top, -1e9));
+        altitude.push_back(std::nextafter(top, 1e9));
+    }
+    altitude.push_back(-0.0);
+    altitude.push_back(std::nan(""));
+    std::uniform_real_distribution<double> height(-2500.0, 96000.0);
+    while (altitude.size() < count) altitude.push_back(height(random));
+
+    // Таблица интерполяции с неравномерными узлами и точки внутри, на узлах и вне её
+    std::vector<double> xs, ys;
+    for (int i = 0; i < 24; ++i) {
+        xs.push_back(0.01 + 0.45 * i + 0.05 * (i % 3));
+        ys.push_back(std::sin(0.7 * i) + 0.3);
+    }
+    std::vector<double> x(xs);
+    x.push_back(std::nan(""));
+    std::uniform_real_distribution<double> mach(-0.5, 11.5);
+    while (x.size() < count) x.push_back(mach(random));
+
+    const std::vector<const KernelSet*> sets = availableKernels();
+    std::vector<double> reference[6];
+    bool ok = true;
+
+    out << std::left << std::setw(8) << "ISA" << std::right
+        // setw считает байты: кириллица в UTF-8 занимает по два
+        << std::setw(14 + 2) << "a,g (нс)" << std::setw(14 + 5) << "все (нс)" << std::setw(14 + 8) << "интерп. (нс)"
+        << "  результат\n";
+    for (const KernelSet* set : sets) {
+        std::vector<double> T(count), p(count), ro(count), a(count), g(count), y(count);
+        std::vector<double> a_only(count), g_only(count);
+
+        AtmosphereColumns light;
+        light.a = a_only.data();
+        light.g = g_only.data();
+        Clock::time_point t0 = Clock::now();
+        set->atmosphere(altitude.data(), count, light);
+        Clock::time_point t1 = Clock::now();
+
+        AtmosphereColumns full;
+        full.T = T.data();
+        full.p = p.data();
+        full.ro = ro.data();
+        full.a = a.data();
+        full.g = g.data();
+        set->atmosphere(altitude.data(), count, full);
+        Clock::time_point t2 = Clock::now();
+
+        set->interpolate(xs.data(), ys.data(), xs.size(), x.data(), count, y.data());
+        Clock::time_point t3 = Clock::now();
+
+        bool same = same_bits(a, a_only) && same_bits(g, g_only);
+        if (reference[0].empty()) {
+            // Базовый вариант сверяется с поточечным расчётом
+            for (size_t i = 0; i < count && same; ++i) {
+                if (altitude[i] < -2000.0 || altitude[i] > 94000.0) continue;
+                AtmosphereParams atm = calculate_atmosphere(altitude[i]);
+                const double expected[5] = {atm.T, atm.p, atm.ro, atm.a, atm.g};
+                const double actual[5] = {T[i], p[i], ro[i], a[i], g[i]};
+                same = std::memcmp(expected, actual, sizeof(expected)) == 0;
+            }
+            for (size_t i = 0; i < count && same; ++i) {
+                const double expected = interpolate_linear(x[i], xs, ys);
+                same = std::memcmp(&expected, &y[i], sizeof(expected)) == 0;
+            }
+            reference[0] = T; reference[1] = p; reference[2] = ro;
+            reference[3] = a; reference[4] = g; reference[5] = y;
+        } else {
+            same = same && same_bits(T, reference[0]) && same_bits(p, reference[1])
+                && same_bits(ro, reference[2]) && same_bits(a, reference[3])
+                && same_bits(g, reference[4]) && same_bits(y, reference[5]);
+        }
+        ok = ok && same;
+
+        auto per_item = [count](Clock::time_point from, Clock::time_point to) {
+            return std::chrono::duration<double, std::nano>(to - from).count() / static_cast<double>(count);
+        };
+        out << std::left << std::setw(8) << set->name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(14) << per_item(t0, t1) << std::setw(14) << per_item(t1, t2)
+            << std::setw(14) << per_item(t2, t3) << "  " << (same ? "совпадает" : "РАСХОЖДЕНИЕ") << "\n"
+            << std::defaultfloat;
+    }
+    out << "Выбран вариант: " << kernels().name << "\n";
+    return ok;
+}
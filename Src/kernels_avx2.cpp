@@ -0,0 +1,4 @@
+// Вариант пакетных ядер "avx2" (флаги набора команд - в CMakeLists.txt)
+#define KERNEL_NAMESPACE kernels_avx2
+#define KERNEL_NAME "avx2"
+#include "kernels_impl.h"
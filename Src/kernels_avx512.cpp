@@ -0,0 +1,4 @@
+// Вариант пакетных ядер "avx512" (флаги набора команд - в CMakeLists.txt)
+#define KERNEL_NAMESPACE kernels_avx512
+#define KERNEL_NAME "avx512"
+#include "kernels_impl.h"
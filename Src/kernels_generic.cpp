@@ -0,0 +1,4 @@
+// Вариант пакетных ядер "generic" (флаги набора команд - в CMakeLists.txt)
+#define KERNEL_NAMESPACE kernels_generic
+#define KERNEL_NAME "generic"
+#include "kernels_impl.h"
@@ -0,0 +1,135 @@
+// Исходный текст пакетных ядер (kernels.h). Включается только файлами
+// вариантов Src/kernels_*.cpp, которые задают KERNEL_NAMESPACE и KERNEL_NAME
+// и компилируются каждый со своими флагами набора команд.
+
+#include "kernels.h"
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cmath>
+
+#ifdef ATMOSPHERE_MODEL_H
+#error "atmosphere_model.h должен включаться только внутри KERNEL_NAMESPACE"
+#endif
+
+namespace KERNEL_NAMESPACE {
+
+// Формулы атмосферы - своя копия в каждом варианте: inline-функции с внешней
+// связью, собранные с -mavx512f, иначе компоновщик мог бы оставить вместо общих
+// для calculate_atmosphere и остальных вариантов (SIGILL на процессорах без AVX-512).
+// <cmath> включён выше, в глобальном пространстве имён.
+#include "atmosphere_model.h"
+
+using namespace atmosphere_model;
+
+// Размер блока: временные столбцы блока помещаются в L1
+const size_t CHUNK = 256;
+
+void atmosphere(const double* altitude, size_t count, const AtmosphereColumns& out) {
+    const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    // Параметры слоёв; опорные высоты - тем же выражением, что в calculate_atmosphere
+    double H_base[LAYER_COUNT], iso[LAYER_COUNT];
+    for (int k = 0; k < LAYER_COUNT; ++k) {
+        H_base[k] = geopotential_height(LAYERS[k].bottom);
+        iso[k] = isothermal(LAYERS[k]) ? 1.0 : 0.0;
+    }
+
+    double H_geo[CHUNK], T[CHUNK];
+    std::int64_t layer[CHUNK];
+    const bool need_pressure = out.p != nullptr || out.ro != nullptr;
+
+    for (size_t first = 0; first < count; first += CHUNK) {
+        const size_t n = std::min(CHUNK, count - first);
+        const double* h = altitude + first;
+
+        // Слой - выбором по границам без ветвлений (NaN - последний слой, как find_layer)
+        for (size_t i = 0; i < n; ++i) {
+            const double x = h[i];
+            const bool nan = x != x;
+            double T_base = LAYERS[0].T_base, beta = LAYERS[0].beta, Hb = H_base[0], flat = iso[0];
+            std::int64_t k = 0;
+#pragma GCC unroll 8
+            for (int j = 1; j < LAYER_COUNT; ++j) {
+                const bool above = nan | (x > LAYERS[j - 1].top);
+                T_base = above ? LAYERS[j].T_base : T_base;
+                beta = above ? LAYERS[j].beta : beta;
+                Hb = above ? H_base[j] : Hb;
+                flat = above ? iso[j] : flat;
+                k = above ? j : k;
+            }
+            const double H = geopotential_height(x);
+            H_geo[i] = H;
+            layer[i] = k;
+            T[i] = flat != 0.0 ? T_base : T_base + beta * (H - Hb);
+        }
+
+        // Давление: pow и log10 из libm поточечно - те же вызовы, что в calculate_atmosphere
+        double p[CHUNK];
+        if (need_pressure) {
+            for (size_t i = 0; i < n; ++i) {
+                p[i] = pressure(LAYERS[layer[i]], H_geo[i], H_base[layer[i]]);
+            }
+        }
+
+        // Вне диапазона - NaN; столбцы по отдельности, чтобы каждый цикл векторизовался
+        auto outside = [h](size_t i) { return (h[i] < H_MIN) | (h[i] > H_MAX); };
+        if (out.T) {
+            double* dst = out.T + first;
+            for (size_t i = 0; i < n; ++i) dst[i] = outside(i) ? NaN : T[i];
+        }
+        if (out.a) {
+            double* dst = out.a + first;
+            for (size_t i = 0; i < n; ++i) dst[i] = outside(i) ? NaN : sound_speed(T[i]);
+        }
+        if (out.g) {
+            double* dst = out.g + first;
+            for (size_t i = 0; i < n; ++i) dst[i] = outside(i) ? NaN : gravity(h[i]);
+        }
+        if (out.p) {
+            double* dst = out.p + first;
+            for (size_t i = 0; i < n; ++i) dst[i] = outside(i) ? NaN : p[i];
+        }
+        if (out.ro) {
+            double* dst = out.ro + first;
+            for (size_t i = 0; i < n; ++i) dst[i] = outside(i) ? NaN : density(p[i], T[i]);
+        }
+    }
+}
+
+void interpolate(const double* xs, const double* ys, size_t nodes,
+                 const double* x, size_t count, double* out) {
+    const double front = xs[0], back = xs[nodes - 1];
+    std::int32_t interval[CHUNK];
+
+    for (size_t first = 0; first < count; first += CHUNK) {
+        const size_t n = std::min(CHUNK, count - first);
+        const double* v = x + first;
+
+        // Интервал xs[i] < x <= xs[i+1] - число внутренних узлов левее x
+        for (size_t i = 0; i < n; ++i) interval[i] = 0;
+        for (size_t j = 1; j + 1 < nodes; ++j) {
+            const double node = xs[j];
+            for (size_t i = 0; i < n; ++i) {
+                interval[i] += v[i] > node ? 1 : 0;
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            const std::int32_t k = interval[i];
+            const double t = (v[i] - xs[k]) / (xs[k + 1] - xs[k]);
+            double r = ys[k] + t * (ys[k + 1] - ys[k]);
+            r = v[i] != v[i] ? ys[nodes - 1] : r;
+            r = v[i] >= back ? ys[nodes - 1] : r;
+            r = v[i] <= front ? ys[0] : r;
+            out[first + i] = r;
+        }
+    }
+}
+
+const KernelSet& kernel_set() {
+    static const KernelSet set = {KERNEL_NAME, atmosphere, interpolate};
+    return set;
+}
+
+} // namespace KERNEL_NAMESPACE
@@ -0,0 +1,4 @@
+// Вариант пакетных ядер "sse4.2" (флаги набора команд - в CMakeLists.txt)
+#define KERNEL_NAMESPACE kernels_sse42
+#define KERNEL_NAME "sse4.2"
+#include "kernels_impl.h"
@@ -0,0 +1,272 @@
+#include "lookup_table.h"
+#include <fstream>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char TABLE_MAGIC[8] = {'B', 'A', 'L', 'T', 'B', 'L', '0', '1'};
+const std::uint64_t BYTE_ORDER_MARK = 0x0102030405060708ULL;
+
+// Заголовок двоичного файла; далее узлы всех осей подряд, затем значения
+struct BinaryHeader {
+    char magic[8];
+    std::uint64_t byte_order;
+    std::uint64_t dims;
+    std::uint64_t components;
+    std::uint64_t meta[4];
+    std::uint64_t axis_len[LookupTable::MAX_DIMS];
+};
+
+// Число double после заголовка; 0 - некорректные размеры
+std::uint64_t payload_size(const BinaryHeader& header) {
+    if (header.dims == 0 || header.dims > LookupTable::MAX_DIMS || header.components == 0) return 0;
+    std::uint64_t axes = 0, nodes = 1;
+    for (std::uint64_t d = 0; d < header.dims; ++d) {
+        std::uint64_t n = header.axis_len[d];
+        if (n == 0 || n > (1ULL << 32)) return 0;
+        axes += n;
+        nodes *= n;
+        if (nodes > (1ULL << 40)) return 0;
+    }
+    return axes + nodes * header.components;
+}
+
+// Интервал x_i < x <= x_{i+1} по узлам axis[0..n); поиск от интервала hint.
+// x должен лежать строго внутри оси
+size_t find_interval(double x, const double* axis, size_t n, size_t hint) {
+    const size_t last = n - 2;
+    size_t i = hint > last ? last : hint;
+    while (i > 0 && x <= axis[i]) --i;
+    while (i < last && x > axis[i + 1]) ++i;
+    return i;
+}
+
+} // namespace
+
+LookupTable::LookupTable(const std::vector<std::vector<double>>& axes, size_t components,
+                         const std::vector<double>& values) {
+    if (axes.empty() || axes.size() > MAX_DIMS || components == 0) {
+        throw std::runtime_error("Таблица: число осей должно быть от 1 до " + std::to_string(MAX_DIMS));
+    }
+
+    std::uint64_t lengths[MAX_DIMS] = {};
+    size_t axes_total = 0, nodes = 1;
+    for (size_t d = 0; d < axes.size(); ++d) {
+        const std::vector<double>& a = axes[d];
+        if (a.empty()) {
+            throw std::runtime_error("Таблица: пустая ось");
+        }
+        for (size_t i = 1; i < a.size(); ++i) {
+            if (!(a[i] > a[i - 1])) {
+                throw std::runtime_error("Таблица: узлы оси должны строго возрастать");
+            }
+        }
+        lengths[d] = a.size();
+        axes_total += a.size();
+        nodes *= a.size();
+    }
+    if (values.size() != nodes * components) {
+        throw std::runtime_error("Таблица: число значений не соответствует сетке");
+    }
+
+    std::shared_ptr<std::vector<double>> buffer = std::make_shared<std::vector<double>>();
+    buffer->reserve(axes_total + values.size());
+    for (const std::vector<double>& a : axes) {
+        buffer->insert(buffer->end(), a.begin(), a.end());
+    }
+    buffer->insert(buffer->end(), values.begin(), values.end());
+
+    setup(axes.size(), lengths, buffer->data(), components);
+    storage = buffer;
+}
+
+void LookupTable::setup(size_t dims, const std::uint64_t* lengths, const double* axes_begin,
+                        size_t components) {
+    const double* ptr = axes_begin;
+    for (size_t d = 0; d < dims; ++d) {
+        axis_ptr[d] = ptr;
+        axis_len[d] = static_cast<size_t>(lengths[d]);
+        ptr += axis_len[d];
+    }
+    size_t stride = 1;
+    for (size_t d = dims; d-- > 0;) {
+        strides[d] = stride;
+        stride *= axis_len[d];
+    }
+    data = ptr;
+    dim_count = dims;
+    component_count = components;
+}
+
+size_t LookupTable::nodeCount() const {
+    size_t nodes = dim_count > 0 ? 1 : 0;
+    for (size_t d = 0; d < dim_count; ++d) nodes *= axis_len[d];
+    return nodes;
+}
+
+void LookupTable::interpolate(const double* x, double* out, size_t* intervals) const {
+    // Базовый узел и доли по осям; оси с нулевой долей (граница, узел с краю) не удваивают углы
+    size_t base = 0;
+    size_t active[MAX_DIMS];
+    double weight[MAX_DIMS];
+    size_t active_count = 0;
+
+    for (size_t d = 0; d < dim_count; ++d) {
+        const double* a = axis_ptr[d];
+        const size_t n = axis_len[d];
+        double v = x[d];
+        size_t i;
+        double t = 0.0;
+        if (n == 1 || v <= a[0]) {
+            i = 0;
+        } else if (v >= a[n - 1] || v != v) {
+            i = n - 1;
+        } else {
+            i = find_interval(v, a, n, intervals != nullptr ? intervals[d] : 0);
+            if (intervals != nullptr) intervals[d] = i;
+            t = (v - a[i]) / (a[i + 1] - a[i]);
+            active[active_count] = d;
+            weight[active_count] = t;
+            ++active_count;
+        }
+        base += i * strides[d];
+    }
+
+    const size_t corners = size_t(1) << active_count;
+    double corner[size_t(1) << MAX_DIMS];
+    for (size_t c = 0; c < component_count; ++c) {
+        for (size_t k = 0; k < corners; ++k) {
+            size_t index = base;
+            for (size_t j = 0; j < active_count; ++j) {
+                if (k & (size_t(1) << j)) index += strides[active[j]];
+            }
+            corner[k] = data[index * component_count + c];
+        }
+        // Свёртка по осям с конца: бит j - верхний узел оси active[j]
+        for (size_t j = active_count; j-- > 0;) {
+            const size_t half = size_t(1) << j;
+            for (size_t k = 0; k < half; ++k) {
+                corner[k] = corner[k] + weight[j] * (corner[k + half] - corner[k]);
+            }
+        }
+        out[c] = corner[0];
+    }
+}
+
+bool LookupTable::saveBinary(const std::string& filename, const Meta& meta) const {
+    if (empty()) return false;
+
+    BinaryHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    header.byte_order = BYTE_ORDER_MARK;
+    header.dims = dim_count;
+    header.components = component_count;
+    for (size_t k = 0; k < meta.size(); ++k) header.meta[k] = meta[k];
+    for (size_t d = 0; d < dim_count; ++d) header.axis_len[d] = axis_len[d];
+
+    std::string tmp_name = filename + ".tmp";
+    {
+        std::ofstream file(tmp_name, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (size_t d = 0; d < dim_count; ++d) {
+            file.write(reinterpret_cast<const char*>(axis_ptr[d]),
+                       static_cast<std::streamsize>(axis_len[d] * sizeof(double)));
+        }
+        file.write(reinterpret_cast<const char*>(data),
+                   static_cast<std::streamsize>(nodeCount() * component_count * sizeof(double)));
+        file.flush();
+        if (!file) {
+            std::remove(tmp_name.c_str());
+            return false;
+        }
+    }
+    // std::filesystem::rename заменяет существующий файл и в Windows
+    std::error_code error;
+    std::filesystem::rename(tmp_name, filename, error);
+    if (error) {
+        std::remove(tmp_name.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool LookupTable::mapBinary(const std::string& filename, LookupTable& table, Meta& meta) {
+    const char* base = nullptr;
+    size_t size = 0;
+    std::shared_ptr<const void> storage;
+
+#ifndef _WIN32
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(BinaryHeader)) {
+        ::close(fd);
+        return false;
+    }
+    size = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    base = static_cast<const char*>(mapping);
+    storage = std::shared_ptr<const void>(mapping, [size](const void* p) {
+        ::munmap(const_cast<void*>(p), size);
+    });
+#else
+    // Без отображения файл читается целиком
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    size = static_cast<size_t>(file.tellg());
+    if (size < sizeof(BinaryHeader)) {
+        return false;
+    }
+    std::shared_ptr<std::vector<double>> buffer =
+        std::make_shared<std::vector<double>>((size + sizeof(double) - 1) / sizeof(double));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(buffer->data()), static_cast<std::streamsize>(size))) {
+        return false;
+    }
+    base = reinterpret_cast<const char*>(buffer->data());
+    storage = buffer;
+#endif
+
+    BinaryHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    if (!std::equal(header.magic, header.magic + sizeof(header.magic), TABLE_MAGIC) ||
+        header.byte_order != BYTE_ORDER_MARK) {
+        return false;
+    }
+    std::uint64_t payload = payload_size(header);
+    if (payload == 0 || size != sizeof(BinaryHeader) + payload * sizeof(double)) {
+        return false;
+    }
+
+    LookupTable result;
+    result.setup(static_cast<size_t>(header.dims), header.axis_len, reinterpret_cast<const double*>(base + sizeof(BinaryHeader)),
+                 static_cast<size_t>(header.components));
+    result.storage = storage;
+    for (size_t k = 0; k < meta.size(); ++k) meta[k] = header.meta[k];
+    table = result;
+    return true;
+}
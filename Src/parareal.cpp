@@ -0,0 +1,193 @@
+#include "parareal.h"
+#include "thread_pool.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Точное решение на отрезке [steps[n], steps[n+1]]
+struct Slice {
+    IntegratorState start;
+    IntegratorState end;
+    std::vector<TrajectoryPoint> points;
+    bool computed = false;
+    bool terminated = false;   // расчёт закончился внутри отрезка (t_end или масса)
+    bool failed = false;
+    std::string error;
+    double seconds = 0.0;
+};
+
+bool same_state(const IntegratorState& a, const IntegratorState& b) {
+    return a.steps == b.steps && a.t == b.t && a.state == b.state;
+}
+
+// Грубый пропагатор: Эйлер с шагом не больше coarse_dt от start до момента t_stop,
+// результат приписывается шагу stop_step точного метода
+IntegratorState coarse_step(const TrajectoryCalculator& calculator, const IntegratorState& start,
+                            double t_stop, unsigned long long stop_step, double coarse_dt,
+                            std::vector<TrajectoryPoint>& scratch) {
+    double span = t_stop - start.t;
+    unsigned long long count = static_cast<unsigned long long>(std::ceil(span / coarse_dt));
+    if (count == 0) count = 1;
+
+    IntegratorState st = start;
+    st.method = EULER;
+    st.dt = span / static_cast<double>(count);
+    st.steps = 1;   // без начальной точки
+    scratch.clear();
+    calculator.continueTrajectory(st, scratch, nullptr, count + 1);
+
+    IntegratorState result = start;
+    result.state = st.state;
+    result.t = t_stop;
+    result.steps = stop_step;
+    return result;
+}
+
+} // namespace
+
+bool calculateTrajectoryParareal(const TrajectoryCalculator& calculator, IntegrationMethod fine_method,
+                                 AlphaLaw alpha_law, double dt, const PararealOptions& options,
+                                 std::vector<TrajectoryPoint>& trajectory, PararealReport* report) {
+    Clock::time_point started = Clock::now();
+    trajectory.clear();
+
+    const VehicleParams params = calculator.params();
+    if (!(dt > 0.0) || !(options.coarse_dt > 0.0)) {
+        std::cerr << "Parareal: шаги dt и coarse_dt должны быть положительными" << std::endl;
+        return false;
+    }
+
+    ThreadPool pool(options.threads);
+    unsigned slice_count = options.slices != 0 ? options.slices : pool.size();
+
+    // Шаги и моменты времени точного метода: t накапливается так же, как в continueTrajectory
+    std::vector<double> step_times(1, 0.0);
+    {
+        double t = 0.0;
+        while (t < params.t_end) {
+            t += dt;
+            step_times.push_back(t);
+        }
+    }
+    const unsigned long long total_steps = step_times.size() - 1;
+    if (total_steps < slice_count) slice_count = static_cast<unsigned>(std::max<unsigned long long>(1, total_steps));
+    const unsigned max_iterations = options.max_iterations != 0 ? options.max_iterations : slice_count;
+
+    std::vector<unsigned long long> boundary(slice_count + 1);
+    for (unsigned n = 0; n <= slice_count; ++n) {
+        boundary[n] = total_steps * n / slice_count;
+    }
+
+    // Начальные приближения на границах - грубый пропагатор
+    std::vector<IntegratorState> U(slice_count + 1), G_old(slice_count + 1);
+    std::vector<TrajectoryPoint> scratch;
+    U[0] = calculator.initialState(fine_method, alpha_law, dt);
+    try {
+        for (unsigned n = 0; n < slice_count; ++n) {
+            U[n + 1] = coarse_step(calculator, U[n], step_times[boundary[n + 1]], boundary[n + 1],
+                                   options.coarse_dt, scratch);
+            G_old[n + 1] = U[n + 1];
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Parareal: ошибка грубого пропагатора: " << e.what() << std::endl;
+        return false;
+    }
+
+    std::vector<Slice> slices(slice_count);
+    PararealReport result;
+    result.slices = slice_count;
+    unsigned last_slice = slice_count - 1;
+
+    for (unsigned iteration = 1; ; ++iteration) {
+        // Точные решения на отрезках, начальное состояние которых изменилось
+        for (unsigned n = 0; n < slice_count; ++n) {
+            Slice& slice = slices[n];
+            if (slice.computed && same_state(slice.start, U[n])) continue;
+            slice.start = U[n];
+            const unsigned long long stop_step = boundary[n + 1];
+            pool.submit([&calculator, &slice, stop_step]() {
+                Clock::time_point t0 = Clock::now();
+                slice.end = slice.start;
+                slice.points.clear();
+                slice.failed = false;
+                try {
+                    calculator.continueTrajectory(slice.end, slice.points, nullptr, stop_step);
+                } catch (const std::exception& e) {
+                    slice.failed = true;
+                    slice.error = e.what();
+                }
+                slice.terminated = slice.end.steps < stop_step;
+                slice.computed = true;
+                slice.seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+            });
+        }
+        pool.wait();
+
+        if (iteration == 1) {
+            for (const Slice& slice : slices) result.serial_seconds += slice.seconds;
+        }
+
+        // Последовательная коррекция: U[n+1] = F(U_old[n]) + (G(U[n]) - G(U_old[n]))
+        double max_change = 0.0;
+        last_slice = slice_count - 1;
+        try {
+            for (unsigned n = 0; n < slice_count; ++n) {
+                const Slice& slice = slices[n];
+                if (slice.failed) {
+                    std::cerr << "Parareal: ошибка на отрезке " << n << ": " << slice.error << std::endl;
+                    return false;
+                }
+                if (slice.terminated) {
+                    last_slice = n;   // дальнейшие отрезки не нужны
+                    break;
+                }
+                if (n + 1 == slice_count) break;
+
+                IntegratorState G_new = same_state(slice.start, U[n]) ? G_old[n + 1]
+                    : coarse_step(calculator, U[n], step_times[boundary[n + 1]], boundary[n + 1],
+                                  options.coarse_dt, scratch);
+                IntegratorState updated = slice.end;
+                for (size_t i = 0; i < updated.state.size(); ++i) {
+                    // При совпадении грубых решений разность равна нулю и U = F побитово
+                    updated.state[i] = slice.end.state[i] + (G_new.state[i] - G_old[n + 1].state[i]);
+                    double scale = std::max(std::fabs(U[n + 1].state[i]), 1.0);
+                    max_change = std::max(max_change, std::fabs(updated.state[i] - U[n + 1].state[i]) / scale);
+                }
+                U[n + 1] = updated;
+                G_old[n + 1] = G_new;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Parareal: ошибка грубого пропагатора: " << e.what() << std::endl;
+            return false;
+        }
+
+        result.iterations = iteration;
+        result.max_change = max_change;
+        if (max_change <= options.tolerance) {
+            result.converged = true;
+            break;
+        }
+        if (iteration >= max_iterations) break;
+    }
+
+    // Сборка траектории из точных решений
+    for (unsigned n = 0; n <= last_slice; ++n) {
+        trajectory.insert(trajectory.end(), slices[n].points.begin(), slices[n].points.end());
+    }
+    if (!slices[last_slice].terminated) {
+        // Конечная точка - по тому же правилу, что у последовательного расчёта
+        IntegratorState final_state = slices[last_slice].end;
+        calculator.continueTrajectory(final_state, trajectory);
+    }
+
+    result.wall_seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    result.speedup = result.wall_seconds > 0.0 ? result.serial_seconds / result.wall_seconds : 0.0;
+    if (report != nullptr) *report = result;
+    return true;
+}
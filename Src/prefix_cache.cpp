@@ -0,0 +1,123 @@
+#include "prefix_cache.h"
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+bool same_params(const VehicleParams& a, const VehicleParams& b) {
+    return a.V0 == b.V0 && a.theta_c0 == b.theta_c0 && a.m_dot == b.m_dot && a.W == b.W &&
+           a.y0 == b.y0 && a.omega_z0 == b.omega_z0 && a.theta0 == b.theta0 &&
+           a.t_end == b.t_end && a.m0 == b.m0 && a.I_d == b.I_d && a.S_a == b.S_a && a.S_m == b.S_m;
+}
+
+bool same_pitch(const PitchDynamics& a, const PitchDynamics& b) {
+    return a.enabled == b.enabled && a.I_z0 == b.I_z0 && a.L == b.L && a.mz_omegaz == b.mz_omegaz;
+}
+
+} // namespace
+
+TrajectoryPrefixCache::TrajectoryPrefixCache(unsigned long long snapshot_interval)
+    : snapshot_interval(snapshot_interval > 0 ? snapshot_interval : 1) {}
+
+TrajectoryPrefixCache::Key TrajectoryPrefixCache::makeKey(const TrajectoryCalculator& calculator,
+                                                          IntegrationMethod method, AlphaLaw alpha_law,
+                                                          double dt) {
+    Key k;
+    k.params = calculator.params();
+    k.params.t_end = 0.0;
+    k.method = method;
+    k.alpha_law = alpha_law;
+    k.dt = dt;
+    k.atmosphere = calculator.atmosphereProfile();
+    k.aero = calculator.aeroDatabase();
+    k.pitch = calculator.pitchDynamics();
+    k.fast_math = calculator.fastMath();
+    return k;
+}
+
+bool TrajectoryPrefixCache::sameInputs(const Key& k) const {
+    return has_key && same_params(k.params, key.params) && k.method == key.method &&
+           k.alpha_law == key.alpha_law && k.dt == key.dt &&
+           (atmosphere_rebind || k.atmosphere == key.atmosphere) &&
+           (aero_rebind || k.aero == key.aero) &&
+           same_pitch(k.pitch, key.pitch) && k.fast_math == key.fast_math;
+}
+
+bool TrajectoryPrefixCache::calculate(const TrajectoryCalculator& calculator, IntegrationMethod method,
+                                      AlphaLaw alpha_law, double dt, std::vector<TrajectoryPoint>& trajectory,
+                                      std::string* error) {
+    ++counters.runs;
+    Key k = makeKey(calculator, method, alpha_law, dt);
+    if (!sameInputs(k)) snapshots.clear();
+    key = k;
+    has_key = true;
+    aero_rebind = false;
+    atmosphere_rebind = false;
+
+    // Последний снимок, после которого расчёт с новым t_end ещё продолжается:
+    // все шаги до него выполнены и в полном расчёте
+    const double t_end = calculator.params().t_end;
+    size_t valid = snapshots.size();
+    while (valid > 0 && !(snapshots[valid - 1].state.t < t_end)) --valid;
+    snapshots.resize(valid);
+
+    try {
+        trajectory.clear();
+        size_t expected = calculator.expectedPointCount(dt);
+        if (trajectory.capacity() < expected) trajectory.reserve(expected);
+
+        IntegratorState st;
+        if (snapshots.empty()) {
+            st = calculator.initialState(method, alpha_law, dt);
+        } else {
+            const Snapshot& from = snapshots.back();
+            st = from.state;
+            trajectory.assign(points.begin(), points.begin() + static_cast<std::ptrdiff_t>(from.points));
+            ++counters.resumed;
+            counters.reused_steps += st.steps;
+        }
+        const unsigned long long start_steps = st.steps;
+
+        CheckpointHook hook;
+        hook.interval = snapshot_interval;
+        hook.callback = [this](const IntegratorState& current, const std::vector<TrajectoryPoint>& prefix) {
+            snapshots.push_back(Snapshot{current, prefix.size()});
+        };
+        calculator.continueTrajectory(st, trajectory, &hook);
+
+        counters.computed_steps += st.steps - start_steps;
+        points = trajectory;
+        return true;
+    } catch (const std::exception& e) {
+        if (error != nullptr) {
+            *error = e.what();
+        } else {
+            std::cerr << "Ошибка при расчёте траектории: " << e.what() << std::endl;
+        }
+        trajectory.clear();
+        clear();
+        return false;
+    }
+}
+
+void TrajectoryPrefixCache::aeroChangedFrom(double mach) {
+    size_t valid = 0;
+    while (valid < snapshots.size() && snapshots[valid].state.envelope.max_mach < mach) ++valid;
+    snapshots.resize(valid);
+    aero_rebind = true;
+}
+
+void TrajectoryPrefixCache::atmosphereChangedFrom(double altitude) {
+    size_t valid = 0;
+    while (valid < snapshots.size() && snapshots[valid].state.envelope.max_altitude < altitude) ++valid;
+    snapshots.resize(valid);
+    atmosphere_rebind = true;
+}
+
+void TrajectoryPrefixCache::clear() {
+    has_key = false;
+    aero_rebind = false;
+    atmosphere_rebind = false;
+    snapshots.clear();
+    points.clear();
+}
@@ -0,0 +1,259 @@
+// Модуль Python "ballistics" поверх TrajectoryCalculator.
+//
+// Траектория возвращается объектом Trajectory, который владеет
+// std::vector<TrajectoryPoint> и отдаёт его память через протокол буфера
+// (PEP 3118) как одномерный массив структур. numpy.asarray(traj) даёт
+// структурированный массив-представление без копирования:
+//
+//     import numpy as np, ballistics
+//     calc = ballistics.TrajectoryCalculator(V0=70.5, theta_c0=40.0, ...)
+//     arr = np.asarray(calc.calculate(ballistics.RUNGE_KUTTA_4,
+//                                     ballistics.ALPHA_THETA_MINUS_THETAC, 0.01))
+//     arr["t"], arr["V"], arr["y"]   # столбцы-представления
+//
+// На время интегрирования GIL отпускается, поэтому пакеты расчётов
+// можно запускать параллельно из нескольких потоков Python.
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "trajectory.h"
+#include <new>
+#include <utility>
+#include <vector>
+
+static_assert(sizeof(TrajectoryPoint) == 17 * sizeof(double),
+              "TrajectoryPoint должен состоять только из 17 полей double");
+
+namespace {
+
+// Формат элемента буфера: порядок полей совпадает с TrajectoryPoint
+const char* const POINT_FORMAT =
+    "T{d:t:d:V:d:theta_c:d:x:d:y:d:omega_z:d:theta:d:m:d:P:d:g:"
+    "d:M:d:Cxa:d:Cya_alpha:d:alpha:d:x_dotc:d:y_dotc:d:V_dot:}";
+
+const char* const POINT_FIELDS[] = {
+    "t", "V", "theta_c", "x", "y", "omega_z", "theta", "m", "P", "g",
+    "M", "Cxa", "Cya_alpha", "alpha", "x_dotc", "y_dotc", "V_dot"
+};
+
+// ---------------------------------------------------------------------------
+// Trajectory
+// ---------------------------------------------------------------------------
+
+struct PyTrajectory {
+    PyObject_HEAD
+    std::vector<TrajectoryPoint>* points;
+    Py_ssize_t shape[1];
+    Py_ssize_t strides[1];
+};
+
+PyTypeObject PyTrajectoryType = { PyVarObject_HEAD_INIT(nullptr, 0) };
+
+void Trajectory_dealloc(PyTrajectory* self) {
+    delete self->points;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+Py_ssize_t Trajectory_len(PyTrajectory* self) {
+    return static_cast<Py_ssize_t>(self->points->size());
+}
+
+int Trajectory_getbuffer(PyTrajectory* self, Py_buffer* view, int flags) {
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "Траектория доступна только для чтения");
+        view->obj = nullptr;
+        return -1;
+    }
+
+    view->obj = reinterpret_cast<PyObject*>(self);
+    Py_INCREF(view->obj);
+    view->buf = self->points->data();
+    view->len = static_cast<Py_ssize_t>(self->points->size() * sizeof(TrajectoryPoint));
+    view->readonly = 1;
+    view->itemsize = sizeof(TrajectoryPoint);
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(POINT_FORMAT) : nullptr;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? self->shape : nullptr;
+    view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES) ? self->strides : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    return 0;
+}
+
+PyBufferProcs Trajectory_as_buffer;
+PySequenceMethods Trajectory_as_sequence;
+
+// Оборачивает готовый вектор точек без копирования
+PyObject* wrapTrajectory(std::vector<TrajectoryPoint>&& points) {
+    PyTrajectory* self = PyObject_New(PyTrajectory, &PyTrajectoryType);
+    if (self == nullptr) {
+        return nullptr;
+    }
+    self->points = new (std::nothrow) std::vector<TrajectoryPoint>(std::move(points));
+    if (self->points == nullptr) {
+        Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+        return PyErr_NoMemory();
+    }
+    self->shape[0] = static_cast<Py_ssize_t>(self->points->size());
+    self->strides[0] = sizeof(TrajectoryPoint);
+    return reinterpret_cast<PyObject*>(self);
+}
+
+// ---------------------------------------------------------------------------
+// TrajectoryCalculator
+// ---------------------------------------------------------------------------
+
+struct PyCalculator {
+    PyObject_HEAD
+    TrajectoryCalculator* calculator;
+};
+
+PyTypeObject PyCalculatorType = { PyVarObject_HEAD_INIT(nullptr, 0) };
+
+int Calculator_init(PyCalculator* self, PyObject* args, PyObject* kwds) {
+    static const char* kwlist[] = {"V0", "theta_c0", "m_dot", "W", "y0", "omega_z0", "theta0",
+                                   "t_end", "m0", "I_d", "S_a", "S_m", nullptr};
+    double V0, theta_c0, m_dot, W, y0, omega_z0, theta0, t_end, m0, I_d, S_a, S_m;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "dddddddddddd", const_cast<char**>(kwlist),
+                                     &V0, &theta_c0, &m_dot, &W, &y0, &omega_z0, &theta0,
+                                     &t_end, &m0, &I_d, &S_a, &S_m)) {
+        return -1;
+    }
+
+    // Повторный __init__ не допускается: другой поток может считать с этим
+    // калькулятором без GIL, и его нельзя удалить или заменить
+    if (self->calculator != nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "TrajectoryCalculator уже инициализирован");
+        return -1;
+    }
+    self->calculator = new (std::nothrow) TrajectoryCalculator(V0, theta_c0, m_dot, W, y0, omega_z0,
+                                                               theta0, t_end, m0, I_d, S_a, S_m);
+    if (self->calculator == nullptr) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    return 0;
+}
+
+void Calculator_dealloc(PyCalculator* self) {
+    delete self->calculator;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+PyObject* Calculator_calculate(PyCalculator* self, PyObject* args, PyObject* kwds) {
+    static const char* kwlist[] = {"method", "alpha_law", "dt", nullptr};
+    int method = RUNGE_KUTTA_4;
+    int alpha_law = ALPHA_THETA_MINUS_THETAC;
+    double dt = 0.1;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|iid", const_cast<char**>(kwlist),
+                                     &method, &alpha_law, &dt)) {
+        return nullptr;
+    }
+    if (self->calculator == nullptr) {
+        PyErr_SetString(PyExc_RuntimeError, "TrajectoryCalculator не инициализирован");
+        return nullptr;
+    }
+    if (dt <= 0.0) {
+        PyErr_SetString(PyExc_ValueError, "Шаг интегрирования dt должен быть положительным");
+        return nullptr;
+    }
+    if (method < EULER || method > ROSENBROCK) {
+        PyErr_SetString(PyExc_ValueError, "Неизвестный метод интегрирования");
+        return nullptr;
+    }
+    if (alpha_law < ALPHA_THETA_MINUS_THETAC || alpha_law > ALPHA_ZERO) {
+        PyErr_SetString(PyExc_ValueError, "Неизвестный закон угла атаки");
+        return nullptr;
+    }
+
+    std::vector<TrajectoryPoint> points;
+    const TrajectoryCalculator* calculator = self->calculator;
+    Py_BEGIN_ALLOW_THREADS
+    points = calculator->calculateTrajectory(static_cast<IntegrationMethod>(method),
+                                             static_cast<AlphaLaw>(alpha_law), dt);
+    Py_END_ALLOW_THREADS
+
+    return wrapTrajectory(std::move(points));
+}
+
+PyMethodDef Calculator_methods[] = {
+    {"calculate", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(Calculator_calculate)),
+     METH_VARARGS | METH_KEYWORDS,
+     "calculate(method=RUNGE_KUTTA_4, alpha_law=ALPHA_THETA_MINUS_THETAC, dt=0.1) -> Trajectory"},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+// ---------------------------------------------------------------------------
+// Модуль
+// ---------------------------------------------------------------------------
+
+PyModuleDef ballistics_module = {
+    PyModuleDef_HEAD_INIT,
+    "ballistics",
+    "Расчёт траекторий на активном участке; траектории отдаются без копирования",
+    -1,
+    nullptr, nullptr, nullptr, nullptr, nullptr
+};
+
+bool readyTypes() {
+    PyTrajectoryType.tp_name = "ballistics.Trajectory";
+    PyTrajectoryType.tp_basicsize = sizeof(PyTrajectory);
+    PyTrajectoryType.tp_flags = Py_TPFLAGS_DEFAULT;
+    PyTrajectoryType.tp_doc = "Траектория: буфер структур TrajectoryPoint (numpy.asarray без копирования)";
+    PyTrajectoryType.tp_dealloc = reinterpret_cast<destructor>(Trajectory_dealloc);
+    Trajectory_as_buffer.bf_getbuffer = reinterpret_cast<getbufferproc>(Trajectory_getbuffer);
+    Trajectory_as_buffer.bf_releasebuffer = nullptr;
+    PyTrajectoryType.tp_as_buffer = &Trajectory_as_buffer;
+    Trajectory_as_sequence.sq_length = reinterpret_cast<lenfunc>(Trajectory_len);
+    PyTrajectoryType.tp_as_sequence = &Trajectory_as_sequence;
+
+    PyCalculatorType.tp_name = "ballistics.TrajectoryCalculator";
+    PyCalculatorType.tp_basicsize = sizeof(PyCalculator);
+    PyCalculatorType.tp_flags = Py_TPFLAGS_DEFAULT;
+    PyCalculatorType.tp_doc = "TrajectoryCalculator(V0, theta_c0, m_dot, W, y0, omega_z0, theta0, "
+                              "t_end, m0, I_d, S_a, S_m)";
+    PyCalculatorType.tp_new = PyType_GenericNew;
+    PyCalculatorType.tp_init = reinterpret_cast<initproc>(Calculator_init);
+    PyCalculatorType.tp_dealloc = reinterpret_cast<destructor>(Calculator_dealloc);
+    PyCalculatorType.tp_methods = Calculator_methods;
+
+    return PyType_Ready(&PyTrajectoryType) == 0 && PyType_Ready(&PyCalculatorType) == 0;
+}
+
+} // namespace
+
+PyMODINIT_FUNC PyInit_ballistics(void) {
+    if (!readyTypes()) {
+        return nullptr;
+    }
+
+    PyObject* module = PyModule_Create(&ballistics_module);
+    if (module == nullptr) {
+        return nullptr;
+    }
+
+    PyObject* fields = PyTuple_New(sizeof(POINT_FIELDS) / sizeof(POINT_FIELDS[0]));
+    if (fields == nullptr) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    for (size_t i = 0; i < sizeof(POINT_FIELDS) / sizeof(POINT_FIELDS[0]); ++i) {
+        PyTuple_SET_ITEM(fields, static_cast<Py_ssize_t>(i), PyUnicode_FromString(POINT_FIELDS[i]));
+    }
+
+    Py_INCREF(&PyTrajectoryType);
+    Py_INCREF(&PyCalculatorType);
+    if (PyModule_AddObject(module, "Trajectory", reinterpret_cast<PyObject*>(&PyTrajectoryType)) < 0 ||
+        PyModule_AddObject(module, "TrajectoryCalculator", reinterpret_cast<PyObject*>(&PyCalculatorType)) < 0 ||
+        PyModule_AddObject(module, "FIELDS", fields) < 0 ||
+        PyModule_AddIntConstant(module, "EULER", EULER) < 0 ||
+        PyModule_AddIntConstant(module, "MODIFIED_EULER", MODIFIED_EULER) < 0 ||
+        PyModule_AddIntConstant(module, "RUNGE_KUTTA_4", RUNGE_KUTTA_4) < 0 ||
+        PyModule_AddIntConstant(module, "ROSENBROCK", ROSENBROCK) < 0 ||
+        PyModule_AddIntConstant(module, "ALPHA_THETA_MINUS_THETAC", ALPHA_THETA_MINUS_THETAC) < 0 ||
+        PyModule_AddIntConstant(module, "ALPHA_ZERO", ALPHA_ZERO) < 0) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
@@ -0,0 +1,153 @@
+#include "realtime_stepper.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <stdexcept>
+#include <vector>
+
+RealtimeStepper::RealtimeStepper(const TrajectoryCalculator& calculator, IntegrationMethod method,
+                                 AlphaLaw alpha_law)
+    : calculator(calculator), method(method), alpha_law(alpha_law) {
+    if (method != EULER && method != MODIFIED_EULER && method != RUNGE_KUTTA_4 && method != ROSENBROCK) {
+        throw std::invalid_argument("Неизвестный метод интегрирования");
+    }
+    reset();
+}
+
+void RealtimeStepper::reset() noexcept {
+    IntegratorState initial = calculator.initialState(method, alpha_law, 0.0);
+    t = initial.t;
+    current = initial.state;
+    step_count = 0;
+    cursors = LookupCursors();
+}
+
+void RealtimeStepper::setState(double time, const StateVector& state) noexcept {
+    t = time;
+    current = state;
+}
+
+void RealtimeStepper::commandOmegaZ(double omega_z) noexcept {
+    control.omega_z = omega_z;
+}
+
+void RealtimeStepper::commandAlpha(double alpha) noexcept {
+    control.alpha = alpha;
+}
+
+void RealtimeStepper::clearCommands() noexcept {
+    control = ControlCommand();
+}
+
+bool RealtimeStepper::step(double dt) noexcept {
+    if (!(dt > 0.0) || !std::isfinite(dt)) return false;
+
+    const bool omega_commanded = control.omega_z == control.omega_z;
+    if (omega_commanded) current[4] = control.omega_z;
+    const ControlCommand* command = omega_commanded || control.alpha == control.alpha ? &control : nullptr;
+
+    switch (method) {
+        case EULER:
+            calculator.stepEuler(t, current, dt, alpha_law, cursors, command);
+            break;
+        case MODIFIED_EULER:
+            calculator.stepModifiedEuler(t, current, dt, alpha_law, cursors, command);
+            break;
+        case ROSENBROCK:
+            calculator.stepRosenbrock(t, current, dt, alpha_law, cursors, command);
+            break;
+        case RUNGE_KUTTA_4:
+        default:
+            calculator.stepRungeKutta4(t, current, dt, alpha_law, cursors, command);
+            break;
+    }
+
+    // Те же ограничения, что в цикле calculateTrajectory
+    if (current[3] < 0) current[3] = 0;
+    if (current[0] < 0) current[0] = 0;
+    t += dt;
+    ++step_count;
+    return true;
+}
+
+TrajectoryPoint RealtimeStepper::point() noexcept {
+    const ControlCommand* command = control.omega_z == control.omega_z || control.alpha == control.alpha
+                                    ? &control : nullptr;
+    StateVector derivatives;
+    calculator.calculateDerivatives(t, current, derivatives, alpha_law, cursors, nullptr, command);
+    TrajectoryPoint result = calculator.makeTrajectoryPoint(t, current, derivatives, alpha_law, cursors);
+    if (command != nullptr && command->alpha == command->alpha) result.alpha = command->alpha;
+    return result;
+}
+
+bool RealtimeStepper::finished() const noexcept {
+    const VehicleParams p = calculator.params();
+    return !(t < p.t_end && current[6] > 0.1 * p.m0);
+}
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double percentile(const std::vector<double>& sorted, double q) {
+    size_t index = static_cast<size_t>(q * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+} // namespace
+
+bool realtimeBenchmark(const TrajectoryCalculator& calculator, const RealtimeBenchOptions& options,
+                       std::ostream& out) {
+    const double dt = 1.0 / options.rate;
+
+    // Совпадение с continueTrajectory на первых шагах полёта
+    const unsigned long long CHECK_STEPS = 1000;
+    RealtimeStepper stepper(calculator, options.method, ALPHA_THETA_MINUS_THETAC);
+    IntegratorState reference = calculator.initialState(options.method, ALPHA_THETA_MINUS_THETAC, dt);
+    std::vector<TrajectoryPoint> trajectory;
+    calculator.continueTrajectory(reference, trajectory, nullptr, CHECK_STEPS);
+    while (stepper.steps() < reference.steps) stepper.step(dt);
+    const bool same = stepper.state() == reference.state && stepper.time() == reference.t;
+    out << "Шаги совпадают с continueTrajectory (" << reference.steps << " шагов): "
+        << (same ? "да" : "НЕТ") << "\n";
+
+    // Память под замеры выделяется до цикла; прогрев - одна секунда тактов
+    std::vector<double> latency(options.steps);
+    stepper.reset();
+    for (unsigned long long i = 0; i < static_cast<unsigned long long>(options.rate); ++i) {
+        if (stepper.finished()) stepper.reset();
+        stepper.step(dt);
+    }
+    stepper.reset();
+
+    unsigned long long restarts = 0;
+    for (unsigned long long i = 0; i < options.steps; ++i) {
+        if (stepper.finished()) {
+            stepper.reset();
+            ++restarts;
+        }
+        Clock::time_point start = Clock::now();
+        stepper.step(dt);
+        Clock::time_point stop = Clock::now();
+        latency[i] = std::chrono::duration<double>(stop - start).count();
+    }
+
+    double sum = 0.0;
+    for (double value : latency) sum += value;
+    std::vector<double> sorted = latency;
+    std::sort(sorted.begin(), sorted.end());
+    const double period = dt;
+    const size_t overruns = static_cast<size_t>(sorted.end() - std::upper_bound(sorted.begin(), sorted.end(), period));
+
+    out << std::fixed << std::setprecision(2)
+        << "Частота " << options.rate << " Гц, период " << period * 1e6 << " мкс, шагов "
+        << options.steps << " (перезапусков полёта " << restarts << ")\n"
+        << "Задержка шага, мкс: среднее " << sum / static_cast<double>(options.steps) * 1e6
+        << ", медиана " << percentile(sorted, 0.5) * 1e6
+        << ", p99 " << percentile(sorted, 0.99) * 1e6
+        << ", p99.9 " << percentile(sorted, 0.999) * 1e6
+        << ", максимум " << sorted.back() * 1e6 << "\n"
+        << "Запас до периода по p99.9: " << (period - percentile(sorted, 0.999)) * 1e6
+        << " мкс; тактов с превышением периода: " << overruns << "\n" << std::defaultfloat;
+    return same;
+}
@@ -0,0 +1,301 @@
+#include "result_cache.h"
+#include "atmosphere_profile.h"
+#include "aero_database.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char ENTRY_MAGIC[8] = {'B', 'A', 'L', 'R', 'E', 'S', '0', '1'};
+const std::uint32_t HAS_TRAJECTORY = 1;
+
+// Заголовок записи: метка, версия модели, флаги, ключ, конечное состояние, число точек
+const std::uint64_t HEADER_SIZE = sizeof(ENTRY_MAGIC) + 2 * sizeof(std::uint32_t) +
+                                  2 * sizeof(std::uint64_t) + sizeof(TrajectoryPoint) +
+                                  sizeof(std::uint64_t);
+
+// Временные файлы прерванных записей удаляются при вытеснении через час
+const std::chrono::hours STALE_TEMP_AGE(1);
+
+template <typename T>
+void write_raw(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool read_raw(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+// FNV-1a, 128 бит; число хранится половинами по 64 бита (без __int128, для MSVC)
+struct Fnv128 {
+    std::uint64_t high = 0x6c62272e07bb0142ULL;
+    std::uint64_t low = 0x62b821756295c58dULL;
+
+    void mix(const void* data, size_t size) {
+        // Простое число FNV 2^88 + 0x13b: hash * prime = hash * 0x13b + (hash << 88) по модулю 2^128
+        const std::uint64_t p = 0x13b;
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            low ^= bytes[i];
+            const std::uint64_t a = (low & 0xffffffffULL) * p;
+            const std::uint64_t b = (low >> 32) * p;
+            const std::uint64_t carry = (b + (a >> 32)) >> 32;   // старшая половина low * p
+            high = high * p + carry + (low << 24);
+            low *= p;
+        }
+    }
+
+    template <typename T>
+    void mix(const T& value) {
+        mix(&value, sizeof(value));
+    }
+};
+
+// Эксклюзивная блокировка файла между процессами на время жизни объекта
+class FileLock {
+public:
+    explicit FileLock(const std::string& filename) {
+#ifndef _WIN32
+        fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd >= 0 && ::flock(fd, LOCK_EX) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+#else
+        (void)filename;
+#endif
+    }
+
+    ~FileLock() {
+#ifndef _WIN32
+        if (fd >= 0) {
+            ::flock(fd, LOCK_UN);
+            ::close(fd);
+        }
+#endif
+    }
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+private:
+    int fd = -1;
+};
+
+} // namespace
+
+ResultCache::ResultCache(const ResultCacheOptions& options) : config(options) {
+    std::error_code error;
+    fs::create_directories(config.directory, error);
+}
+
+ResultKey ResultCache::modelDigest(const BatchOptions& options) {
+    Fnv128 fnv;
+    fnv.mix(RESULT_MODEL_VERSION);
+    fnv.mix(static_cast<std::uint8_t>(options.pitch.enabled));
+    if (options.pitch.enabled) {
+        fnv.mix(options.pitch.I_z0);
+        fnv.mix(options.pitch.L);
+        fnv.mix(options.pitch.mz_omegaz);
+    }
+    fnv.mix(static_cast<std::uint8_t>(options.fast_math));
+
+    std::string content;
+    if (options.atmosphere) options.atmosphere->appendContent(content);
+    fnv.mix(static_cast<std::uint64_t>(content.size()));
+    fnv.mix(content.data(), content.size());
+    content.clear();
+    if (options.aero) options.aero->appendContent(content);
+    fnv.mix(static_cast<std::uint64_t>(content.size()));
+    fnv.mix(content.data(), content.size());
+
+    return ResultKey{fnv.high, fnv.low};
+}
+
+ResultKey ResultCache::key(const BatchCase& c, const ResultKey& model) {
+    Fnv128 fnv;
+    fnv.mix(model[0]);
+    fnv.mix(model[1]);
+    // Поля по одному: в структурах могут быть байты выравнивания
+    const VehicleParams& p = c.params;
+    for (size_t i = 0; i < VEHICLE_FIELD_COUNT; ++i) fnv.mix(vehicleField(p, i));
+    fnv.mix(static_cast<std::int32_t>(c.method));
+    fnv.mix(static_cast<std::int32_t>(c.alpha_law));
+    fnv.mix(c.dt);
+    return ResultKey{fnv.high, fnv.low};
+}
+
+std::string ResultCache::keyName(const ResultKey& key) {
+    char name[33];
+    std::snprintf(name, sizeof(name), "%016llx%016llx", static_cast<unsigned long long>(key[0]),
+                  static_cast<unsigned long long>(key[1]));
+    return name;
+}
+
+std::string ResultCache::entryPath(const ResultKey& key) const {
+    std::string name = keyName(key);
+    return config.directory + "/" + name.substr(0, 2) + "/" + name + ".res";
+}
+
+bool ResultCache::lookup(const ResultKey& key, std::vector<TrajectoryPoint>& trajectory, bool end_state_only) {
+    const std::string path = entryPath(key);
+    std::ifstream file(path, std::ios::binary);
+    bool ok = file.is_open();
+
+    char magic[sizeof(ENTRY_MAGIC)];
+    std::uint32_t version = 0, flags = 0;
+    ResultKey stored = {0, 0};
+    TrajectoryPoint end;
+    std::uint64_t count = 0;
+    ok = ok && file.read(magic, sizeof(magic)) && std::memcmp(magic, ENTRY_MAGIC, sizeof(magic)) == 0 &&
+         read_raw(file, version) && read_raw(file, flags) && read_raw(file, stored[0]) &&
+         read_raw(file, stored[1]) && read_raw(file, end) && read_raw(file, count) &&
+         version == RESULT_MODEL_VERSION && stored == key;
+
+    // Размер проверяется до чтения точек: запись целиком или промах
+    std::error_code error;
+    const std::uint64_t size = ok ? fs::file_size(path, error) : 0;
+    ok = ok && !error && size == HEADER_SIZE + count * sizeof(TrajectoryPoint);
+    if (ok && !end_state_only) {
+        ok = (flags & HAS_TRAJECTORY) != 0 && count > 0;
+        if (ok) {
+            trajectory.resize(count);
+            ok = static_cast<bool>(file.read(reinterpret_cast<char*>(trajectory.data()),
+                                             static_cast<std::streamsize>(count * sizeof(TrajectoryPoint))));
+        }
+    } else if (ok) {
+        trajectory.assign(1, end);
+    }
+
+    if (!ok) {
+        ++misses;
+        trajectory.clear();
+        return false;
+    }
+    ++hits;
+    // Время изменения - время последнего использования (LRU)
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    return true;
+}
+
+void ResultCache::store(const ResultKey& key, const std::vector<TrajectoryPoint>& trajectory) {
+    if (trajectory.empty()) return;
+    const std::string path = entryPath(key);
+    std::error_code error;
+    // Без траекторий существующая запись (возможно, с траекторией) не заменяется
+    if (!config.trajectories && fs::exists(path, error)) return;
+    fs::create_directories(fs::path(path).parent_path(), error);
+
+    const std::uint64_t count = config.trajectories ? trajectory.size() : 0;
+    std::string tmp_name = path + ".tmp." + std::to_string(
+#ifndef _WIN32
+        static_cast<long long>(::getpid())
+#else
+        0LL
+#endif
+    ) + "." + std::to_string(temp_counter.fetch_add(1));
+    {
+        std::ofstream file(tmp_name, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return;
+        file.write(ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+        write_raw(file, static_cast<std::uint32_t>(RESULT_MODEL_VERSION));
+        write_raw(file, static_cast<std::uint32_t>(config.trajectories ? HAS_TRAJECTORY : 0));
+        write_raw(file, key[0]);
+        write_raw(file, key[1]);
+        write_raw(file, trajectory.back());
+        write_raw(file, count);
+        file.write(reinterpret_cast<const char*>(trajectory.data()),
+                   static_cast<std::streamsize>(count * sizeof(TrajectoryPoint)));
+        file.flush();
+        if (!file) {
+            file.close();
+            std::remove(tmp_name.c_str());
+            return;
+        }
+    }
+    // std::filesystem::rename заменяет существующую запись и в Windows
+    fs::rename(tmp_name, path, error);
+    if (error) {
+        std::remove(tmp_name.c_str());
+        return;
+    }
+    ++stores;
+
+    // Вытеснение после записи примерно восьмой части предела
+    const std::uint64_t size = HEADER_SIZE + count * sizeof(TrajectoryPoint);
+    if (written_since_trim.fetch_add(size) + size > config.max_bytes / 8) {
+        written_since_trim.store(0);
+        trim();
+    }
+}
+
+size_t ResultCache::trim() {
+    FileLock lock(config.directory + "/lock");
+
+    struct Entry {
+        fs::file_time_type time;
+        std::uint64_t size;
+        fs::path path;
+    };
+    std::vector<Entry> entries;
+    std::uint64_t total = 0;
+    const fs::file_time_type now = fs::file_time_type::clock::now();
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(config.directory, error), end; !error && it != end;
+         it.increment(error)) {
+        if (!it->is_regular_file(error)) continue;
+        const fs::path& path = it->path();
+        const std::string name = path.filename().string();
+        fs::file_time_type time = fs::last_write_time(path, error);
+        if (error) continue;
+        if (name.find(".res.tmp.") != std::string::npos) {
+            if (now - time > STALE_TEMP_AGE) fs::remove(path, error);
+            continue;
+        }
+        if (path.extension() != ".res") continue;
+        std::uint64_t size = fs::file_size(path, error);
+        if (error) continue;
+        entries.push_back(Entry{time, size, path});
+        total += size;
+    }
+    error.clear();
+
+    size_t removed = 0;
+    if (total > config.max_bytes) {
+        const std::uint64_t target = config.max_bytes / 10 * 9;
+        std::sort(entries.begin(), entries.end(),
+                  [](const Entry& a, const Entry& b) { return a.time < b.time; });
+        for (const Entry& entry : entries) {
+            if (total <= target) break;
+            if (fs::remove(entry.path, error)) {
+                total -= entry.size;
+                ++removed;
+            }
+        }
+    }
+    evicted += removed;
+    return removed;
+}
+
+ResultCache::Stats ResultCache::stats() const {
+    Stats s;
+    s.hits = hits.load();
+    s.misses = misses.load();
+    s.stores = stores.load();
+    s.evicted = evicted.load();
+    return s;
+}
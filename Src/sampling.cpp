@@ -0,0 +1,296 @@
+#include "sampling.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cmath>
+
+namespace {
+
+// Направляющие числа Joe-Kuo (new-joe-kuo-6.21201) для осей 2..21: s, a, m_1..m_s
+struct JoeKuoEntry {
+    unsigned s;
+    unsigned a;
+    std::uint32_t m[7];
+};
+
+const JoeKuoEntry JOE_KUO[SobolSequence::MAX_DIMS - 1] = {
+    {1, 0,  {1}},
+    {2, 1,  {1, 3}},
+    {3, 1,  {1, 3, 1}},
+    {3, 2,  {1, 1, 1}},
+    {4, 1,  {1, 1, 3, 3}},
+    {4, 4,  {1, 3, 5, 13}},
+    {5, 2,  {1, 1, 5, 5, 17}},
+    {5, 4,  {1, 1, 5, 5, 5}},
+    {5, 7,  {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6, 1,  {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+    {6, 19, {1, 1, 1, 15, 7, 5}},
+    {6, 22, {1, 3, 1, 15, 13, 25}},
+    {6, 25, {1, 1, 5, 5, 19, 61}},
+    {7, 1,  {1, 3, 7, 11, 23, 15, 103}},
+    {7, 4,  {1, 3, 7, 13, 13, 15, 69}},
+};
+
+std::uint32_t reverse_bits(std::uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+    x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+// Перемешивание 32 бит (финализатор MurmurHash3)
+std::uint32_t hash32(std::uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x85ebca6bu;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35u;
+    x ^= x >> 16;
+    return x;
+}
+
+std::uint32_t hash_combine(std::uint32_t seed, std::uint32_t value) {
+    return hash32(seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+}
+
+// Перестановка Лайне-Карраса: младший бит влияет только на старшие
+std::uint32_t laine_karras_permutation(std::uint32_t x, std::uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+// Вложенное равномерное скремблирование Оуэна (Burley, 2020)
+std::uint32_t nested_uniform_scramble(std::uint32_t x, std::uint32_t seed) {
+    return reverse_bits(laine_karras_permutation(reverse_bits(x), seed));
+}
+
+// Хешированная перестановка [0, length) (Kensler, "Correlated Multi-Jittered Sampling")
+std::uint32_t permute(std::uint32_t i, std::uint32_t length, std::uint32_t p) {
+    std::uint32_t w = length - 1;
+    w |= w >> 1;
+    w |= w >> 2;
+    w |= w >> 4;
+    w |= w >> 8;
+    w |= w >> 16;
+    do {
+        i ^= p;
+        i *= 0xe170893du;
+        i ^= p >> 16;
+        i ^= (i & w) >> 4;
+        i ^= p >> 8;
+        i *= 0x0929eb3fu;
+        i ^= p >> 23;
+        i ^= (i & w) >> 1;
+        i *= 1u | p >> 27;
+        i *= 0x6935fa69u;
+        i ^= (i & w) >> 11;
+        i *= 0x74dcb303u;
+        i ^= (i & w) >> 2;
+        i *= 0x9e501cc3u;
+        i ^= (i & w) >> 2;
+        i *= 0xc860a3dfu;
+        i &= w;
+        i ^= i >> 5;
+    } while (i >= length);
+    return static_cast<std::uint32_t>((static_cast<std::uint64_t>(i) + p) % length);
+}
+
+// 32 бита -> (0, 1) без концов отрезка
+double to_unit(std::uint32_t bits) {
+    return (static_cast<double>(bits) + 0.5) / 4294967296.0;
+}
+
+} // namespace
+
+SobolSequence::SobolSequence(unsigned dims, std::uint32_t seed) : dim_count(dims), seed(seed) {
+    if (dims == 0 || dims > MAX_DIMS) {
+        throw std::invalid_argument("Последовательность Соболя: число осей должно быть от 1 до " +
+                                    std::to_string(MAX_DIMS));
+    }
+
+    directions.assign(static_cast<size_t>(dims) * 32, 0);
+    // Ось 1 - ван дер Корпут
+    for (unsigned k = 0; k < 32; ++k) {
+        directions[k] = 1u << (31 - k);
+    }
+    for (unsigned d = 1; d < dims; ++d) {
+        const JoeKuoEntry& e = JOE_KUO[d - 1];
+        std::uint32_t* v = &directions[static_cast<size_t>(d) * 32];
+        for (unsigned k = 0; k < e.s; ++k) {
+            v[k] = e.m[k] << (31 - k);
+        }
+        for (unsigned k = e.s; k < 32; ++k) {
+            std::uint32_t value = v[k - e.s] ^ (v[k - e.s] >> e.s);
+            for (unsigned j = 1; j < e.s; ++j) {
+                if ((e.a >> (e.s - 1 - j)) & 1u) value ^= v[k - j];
+            }
+            v[k] = value;
+        }
+    }
+}
+
+void SobolSequence::sample(std::uint64_t index, double* out) const {
+    // Номер - 32 бита; точка вычисляется напрямую, без перебора предыдущих
+    const std::uint32_t n = static_cast<std::uint32_t>(index);
+    for (unsigned d = 0; d < dim_count; ++d) {
+        const std::uint32_t* v = &directions[static_cast<size_t>(d) * 32];
+        std::uint32_t x = 0;
+        std::uint32_t bits = n;
+        for (unsigned k = 0; bits != 0; ++k, bits >>= 1) {
+            if (bits & 1u) x ^= v[k];
+        }
+        if (seed != 0) {
+            x = nested_uniform_scramble(x, hash_combine(seed, d));
+        }
+        out[d] = to_unit(x);
+    }
+}
+
+LatinHypercube::LatinHypercube(unsigned dims, std::uint64_t design_size, std::uint32_t seed)
+    : dim_count(dims), design_size(design_size), seed(seed) {
+    if (dims == 0 || design_size == 0 || design_size > (1ULL << 32)) {
+        throw std::invalid_argument("Латинский гиперкуб: некорректное число осей или размер");
+    }
+}
+
+void LatinHypercube::sample(std::uint64_t index, double* out) const {
+    for (unsigned d = 0; d < dim_count; ++d) {
+        std::uint32_t dim_seed = hash_combine(seed, d);
+        // При размере 2^32 перестановка всего диапазона - сам хеш (он биективен)
+        std::uint32_t stratum = design_size == (1ULL << 32)
+            ? hash32(static_cast<std::uint32_t>(index) ^ dim_seed)
+            : permute(static_cast<std::uint32_t>(index), static_cast<std::uint32_t>(design_size), dim_seed);
+        std::uint32_t jitter = hash_combine(dim_seed ^ 0x68bc21ebu, static_cast<std::uint32_t>(index));
+        out[d] = (static_cast<double>(stratum) + to_unit(jitter)) / static_cast<double>(design_size);
+    }
+}
+
+bool parseSamplerKind(const std::string& name, SamplerKind& kind) {
+    if (name == "sobol") kind = SAMPLER_SOBOL;
+    else if (name == "lhs") kind = SAMPLER_LATIN_HYPERCUBE;
+    else return false;
+    return true;
+}
+
+std::vector<ParameterDistribution> loadDispersionSpec(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Ошибка открытия файла разброса: " + filename);
+    }
+
+    std::vector<ParameterDistribution> spec;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        std::istringstream in(line);
+        ParameterDistribution d;
+        std::string law;
+        if (!(in >> d.field >> law >> d.a >> d.b) || vehicleFieldIndex(d.field) == VEHICLE_FIELD_COUNT) {
+            throw std::runtime_error("Ошибка разбора " + filename + ", строка " + std::to_string(line_number));
+        }
+        if (law == "uniform" && d.b >= d.a) {
+            d.law = ParameterDistribution::UNIFORM;
+        } else if (law == "normal" && d.b >= 0.0) {
+            d.law = ParameterDistribution::NORMAL;
+        } else {
+            throw std::runtime_error("Некорректный закон в " + filename + ", строка " + std::to_string(line_number));
+        }
+        spec.push_back(d);
+    }
+    return spec;
+}
+
+// Алгоритм Acklam (относительная погрешность 1.15e-9) с одним шагом уточнения по Галлею
+double inverseNormalCdf(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    const double p_low = 0.02425;
+
+    double x;
+    if (p < p_low) {
+        double q = std::sqrt(-2.0 * std::log(p));
+        x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    } else if (p <= 1.0 - p_low) {
+        double q = p - 0.5;
+        double r = q * q;
+        x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+            (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+    } else {
+        double q = std::sqrt(-2.0 * std::log(1.0 - p));
+        x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+             ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+
+    double e = 0.5 * std::erfc(-x / std::sqrt(2.0)) - p;
+    double u = e * std::sqrt(2.0 * M_PI) * std::exp(x * x / 2.0);
+    return x - u / (1.0 + x * u / 2.0);
+}
+
+std::vector<BatchCase> sampleBatchCases(const BatchCase& base, const std::vector<ParameterDistribution>& spec,
+                                        SamplerKind kind, std::uint64_t first, std::uint64_t count,
+                                        std::uint64_t design_size, std::uint32_t seed) {
+    if (spec.empty()) {
+        throw std::invalid_argument("Выборка: не задано ни одного параметра");
+    }
+    const unsigned dims = static_cast<unsigned>(spec.size());
+
+    std::vector<size_t> fields;
+    for (const ParameterDistribution& d : spec) {
+        fields.push_back(vehicleFieldIndex(d.field));
+        if (fields.back() == VEHICLE_FIELD_COUNT) {
+            throw std::invalid_argument("Выборка: неизвестный параметр " + d.field);
+        }
+    }
+
+    SobolSequence sobol(kind == SAMPLER_SOBOL ? dims : 1, seed);
+    if (kind == SAMPLER_SOBOL && first + count > (1ULL << 32)) {
+        throw std::invalid_argument("Выборка: номера точек Соболя ограничены 2^32");
+    }
+    if (kind == SAMPLER_LATIN_HYPERCUBE && first + count > design_size) {
+        throw std::invalid_argument("Выборка: номера выходят за размер латинского гиперкуба");
+    }
+    LatinHypercube lhs(dims, kind == SAMPLER_LATIN_HYPERCUBE ? design_size : 1, seed);
+
+    std::vector<BatchCase> cases;
+    cases.reserve(count);
+    std::vector<double> u(dims);
+    for (std::uint64_t index = first; index < first + count; ++index) {
+        if (kind == SAMPLER_SOBOL) {
+            sobol.sample(index, u.data());
+        } else {
+            lhs.sample(index, u.data());
+        }
+
+        BatchCase c = base;
+        c.name = base.name + "_" + std::to_string(index);
+        for (unsigned k = 0; k < dims; ++k) {
+            const ParameterDistribution& d = spec[k];
+            double value = d.law == ParameterDistribution::UNIFORM
+                ? d.a + (d.b - d.a) * u[k]
+                : d.a + d.b * inverseNormalCdf(u[k]);
+            vehicleField(c.params, fields[k]) = value;
+        }
+        cases.push_back(c);
+    }
+    return cases;
+}
@@ -0,0 +1,485 @@
+#include "shard.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char SHARD_MAGIC[8] = {'B', 'A', 'L', 'S', 'H', 'R', 'D', '1'};
+const char TRAJECTORIES_MAGIC[8] = {'B', 'A', 'L', 'T', 'R', 'J', '0', '1'};
+
+// Ограничение на число точек записи (защита от повреждённого файла)
+const std::uint64_t MAX_POINTS = 1ULL << 32;
+
+template <typename T>
+void write_raw(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool read_raw(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+void write_points(std::ostream& out, const std::vector<TrajectoryPoint>& points) {
+    write_raw(out, static_cast<std::uint64_t>(points.size()));
+    out.write(reinterpret_cast<const char*>(points.data()),
+              static_cast<std::streamsize>(points.size() * sizeof(TrajectoryPoint)));
+}
+
+void fnv_mix(unsigned long long& hash, const char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+}
+
+// Параметры пакета, не влияющие на результат
+bool result_neutral(const std::string& key) {
+    return key == "--threads" || key == "--checkpoint-period" || key == "--cache" || key == "--cache-size";
+}
+
+/*
+ * Открытый файл шарда: заголовок проверен, таблица смещений прочитана
+ */
+struct ShardFile {
+    std::ifstream in;
+    ShardRange range;
+    std::vector<std::uint64_t> offsets;   // по номерам случаев first..last-1
+};
+
+bool open_shard(const std::string& filename, unsigned long long fingerprint, size_t case_count,
+                unsigned shard, unsigned shards, ShardFile& file) {
+    file.in.open(filename, std::ios::binary);
+    if (!file.in.is_open()) return false;
+
+    char magic[sizeof(SHARD_MAGIC)];
+    std::uint64_t file_fingerprint = 0, file_count = 0, first = 0, last = 0;
+    std::uint32_t file_shard = 0, file_shards = 0;
+    if (!file.in.read(magic, sizeof(magic)) || std::memcmp(magic, SHARD_MAGIC, sizeof(magic)) != 0 ||
+        !read_raw(file.in, file_fingerprint) || !read_raw(file.in, file_count) ||
+        !read_raw(file.in, file_shard) || !read_raw(file.in, file_shards) ||
+        !read_raw(file.in, first) || !read_raw(file.in, last)) {
+        return false;
+    }
+    file.range = shardRange(case_count, shard, shards);
+    if (file_fingerprint != fingerprint || file_count != case_count || file_shard != shard ||
+        file_shards != shards || first != file.range.first || last != file.range.last) {
+        return false;
+    }
+
+    // Конец файла: таблица смещений, её смещение, метка
+    const std::uint64_t cases = last - first;
+    const std::streamoff tail = static_cast<std::streamoff>(sizeof(std::uint64_t) + sizeof(SHARD_MAGIC));
+    std::uint64_t table = 0;
+    if (!file.in.seekg(-tail, std::ios::end)) return false;
+    const std::uint64_t size = static_cast<std::uint64_t>(file.in.tellg()) + tail;
+    if (!read_raw(file.in, table) || !file.in.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, SHARD_MAGIC, sizeof(magic)) != 0 ||
+        table + cases * sizeof(std::uint64_t) + tail != size) {
+        return false;
+    }
+    file.offsets.resize(cases);
+    file.in.seekg(static_cast<std::streamoff>(table));
+    for (std::uint64_t& offset : file.offsets) {
+        if (!read_raw(file.in, offset) || offset >= table) return false;
+    }
+    return true;
+}
+
+// Запись случая index (номер в общем списке) по таблице смещений
+bool read_record(ShardFile& file, size_t index, std::vector<TrajectoryPoint>& points) {
+    std::uint64_t stored = 0, count = 0;
+    file.in.seekg(static_cast<std::streamoff>(file.offsets[index - file.range.first]));
+    if (!read_raw(file.in, stored) || !read_raw(file.in, count) || stored != index || count > MAX_POINTS) {
+        return false;
+    }
+    points.resize(count);
+    return static_cast<bool>(file.in.read(reinterpret_cast<char*>(points.data()),
+                                          static_cast<std::streamsize>(count * sizeof(TrajectoryPoint))));
+}
+
+// Среднее, минимум и максимум величины конечных состояний в порядке номеров случаев
+struct RunningSummary {
+    size_t count = 0;
+    double mean = 0.0;   // поправками: для равных значений среднее равно им точно
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void add(double value) {
+        ++count;
+        mean += (value - mean) / static_cast<double>(count);
+        min = std::min(min, value);
+        max = std::max(max, value);
+    }
+};
+
+bool replace_file(const std::string& tmp_name, const std::string& filename) {
+    // std::filesystem::rename заменяет существующий файл и в Windows
+    std::error_code error;
+    std::filesystem::rename(tmp_name, filename, error);
+    if (error) {
+        std::remove(tmp_name.c_str());
+        std::cerr << "Ошибка записи файла: " << filename << "\n";
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+ShardRange shardRange(size_t case_count, unsigned shard, unsigned shards) {
+    ShardRange range;
+    range.first = case_count * shard / shards;
+    range.last = case_count * (shard + 1) / shards;
+    return range;
+}
+
+std::string shardFileName(const std::string& directory, unsigned shard, unsigned shards) {
+    return directory + "/shards/shard-" + std::to_string(shard) + "-of-" + std::to_string(shards) + ".bin";
+}
+
+unsigned long long shardFingerprint(const std::vector<BatchCase>& cases,
+                                    const std::vector<std::string>& batch_arguments) {
+    unsigned long long hash = batchFingerprint(cases);
+    for (size_t i = 0; i + 1 < batch_arguments.size(); i += 2) {
+        const std::string& key = batch_arguments[i];
+        if (result_neutral(key)) continue;
+        std::string item = key + '\n' + batch_arguments[i + 1] + '\n';
+        fnv_mix(hash, item.data(), item.size());
+        // Таблицы атмосферы и аэродинамики - по содержимому, а не только по имени
+        if (key == "--atmosphere" || key == "--aero") {
+            std::ifstream file(batch_arguments[i + 1], std::ios::binary);
+            std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            fnv_mix(hash, content.data(), content.size());
+        }
+    }
+    return hash;
+}
+
+bool runShardWorker(const std::vector<BatchCase>& cases, unsigned shard, unsigned shards,
+                    const BatchOptions& options, unsigned long long fingerprint,
+                    const std::string& directory) {
+    if (shards == 0 || shard >= shards) {
+        std::cerr << "Неверный номер шарда " << shard << " из " << shards << "\n";
+        return false;
+    }
+    const ShardRange range = shardRange(cases.size(), shard, shards);
+    const std::string filename = shardFileName(directory, shard, shards);
+    const std::string tmp_name = filename + ".tmp";
+    std::error_code error;
+    std::filesystem::create_directories(directory + "/shards", error);
+
+    std::ofstream file(tmp_name, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Ошибка открытия файла шарда: " << tmp_name << "\n";
+        return false;
+    }
+    file.write(SHARD_MAGIC, sizeof(SHARD_MAGIC));
+    write_raw(file, static_cast<std::uint64_t>(fingerprint));
+    write_raw(file, static_cast<std::uint64_t>(cases.size()));
+    write_raw(file, static_cast<std::uint32_t>(shard));
+    write_raw(file, static_cast<std::uint32_t>(shards));
+    write_raw(file, static_cast<std::uint64_t>(range.first));
+    write_raw(file, static_cast<std::uint64_t>(range.last));
+
+    // Повтор упавшего исполнителя считает шард заново: записи временного файла
+    // не переживают перезапуск, поэтому контрольная точка пакета не используется
+    std::vector<BatchCase> subset(cases.begin() + static_cast<std::ptrdiff_t>(range.first),
+                                  cases.begin() + static_cast<std::ptrdiff_t>(range.last));
+    BatchOptions shard_options = options;
+    shard_options.checkpoint_file.clear();
+
+    // Записи - по мере завершения, смещения - по номерам
+    std::vector<std::uint64_t> offsets(subset.size(), 0);
+    std::mutex file_mutex;
+    runBatch(subset, shard_options,
+        [&](unsigned, size_t index, const std::vector<TrajectoryPoint>& trajectory) {
+            std::lock_guard<std::mutex> lock(file_mutex);
+            offsets[index] = static_cast<std::uint64_t>(file.tellp());
+            write_raw(file, static_cast<std::uint64_t>(range.first + index));
+            write_points(file, trajectory);
+        });
+
+    const std::uint64_t table = static_cast<std::uint64_t>(file.tellp());
+    for (std::uint64_t offset : offsets) {
+        write_raw(file, offset);
+    }
+    write_raw(file, table);
+    file.write(SHARD_MAGIC, sizeof(SHARD_MAGIC));
+    file.flush();
+    if (!file) {
+        std::cerr << "Ошибка записи файла шарда: " << tmp_name << "\n";
+        file.close();
+        std::remove(tmp_name.c_str());
+        return false;
+    }
+    file.close();
+
+#ifdef TRAJECTORY_FAULT_INJECTION
+    // Внедрение сбоя для проверки повторов (только в сборке с -DTRAJECTORY_FAULT_INJECTION=ON):
+    // TRAJECTORY_SHARD_FAIL="шард:попытка,..." (попытку передаёт координатор
+    // в TRAJECTORY_SHARD_ATTEMPT, с 1)
+    const char* fail = std::getenv("TRAJECTORY_SHARD_FAIL");
+    const char* attempt = std::getenv("TRAJECTORY_SHARD_ATTEMPT");
+    if (fail != nullptr) {
+        std::string self = std::to_string(shard) + ":" + (attempt != nullptr ? attempt : "1");
+        std::istringstream list(fail);
+        std::string item;
+        while (std::getline(list, item, ',')) {
+            if (item == self) {
+                std::cerr << "Шард " << shard << ": внедрённый сбой\n";
+                std::abort();
+            }
+        }
+    }
+#endif
+
+    return replace_file(tmp_name, filename);
+}
+
+bool shardFileValid(const std::string& filename, unsigned long long fingerprint, size_t case_count,
+                    unsigned shard, unsigned shards) {
+    ShardFile file;
+    return open_shard(filename, fingerprint, case_count, shard, shards, file);
+}
+
+bool mergeShards(const std::vector<BatchCase>& cases, unsigned shards, unsigned long long fingerprint,
+                 const std::string& directory, ShardReport* report) {
+    const std::string end_states_name = directory + "/end_states.txt";
+    const std::string trajectories_name = directory + "/trajectories.bin";
+    const std::string summary_name = directory + "/summary.txt";
+
+    std::ofstream end_states(end_states_name + ".tmp", std::ios::trunc);
+    std::ofstream trajectories(trajectories_name + ".tmp", std::ios::binary | std::ios::trunc);
+    if (!end_states.is_open() || !trajectories.is_open()) {
+        std::cerr << "Ошибка открытия файлов результата в " << directory << "\n";
+        return false;
+    }
+    end_states << "name\tt(c)\tx(m)\ty(m)\tV(m/s)\ttheta_c(grad)\tm(kg)\n";
+    trajectories.write(TRAJECTORIES_MAGIC, sizeof(TRAJECTORIES_MAGIC));
+    write_raw(trajectories, static_cast<std::uint64_t>(cases.size()));
+
+    // Шарды - последовательные части списка, поэтому проход по шардам идёт
+    // по возрастанию номеров случаев при любом их числе
+    const char* names[] = {"t", "x", "y", "V", "theta_c", "m"};
+    RunningSummary summary[6];
+    size_t completed = 0, failed = 0;
+    std::vector<TrajectoryPoint> points;
+    for (unsigned shard = 0; shard < shards; ++shard) {
+        const std::string filename = shardFileName(directory, shard, shards);
+        ShardFile file;
+        if (!open_shard(filename, fingerprint, cases.size(), shard, shards, file)) {
+            std::cerr << "Файл шарда отсутствует, повреждён или от другого расчёта: " << filename << "\n";
+            return false;
+        }
+        for (size_t index = file.range.first; index < file.range.last; ++index) {
+            if (!read_record(file, index, points)) {
+                std::cerr << "Ошибка чтения случая " << index << " из " << filename << "\n";
+                return false;
+            }
+            write_raw(trajectories, static_cast<std::uint64_t>(index));
+            write_points(trajectories, points);
+            ++completed;
+            if (points.empty()) {
+                std::cerr << "Траектория " << cases[index].name << " пуста\n";
+                ++failed;
+                continue;
+            }
+            const TrajectoryPoint& last = points.back();
+            end_states << cases[index].name << "\t" << std::fixed << std::setprecision(3) << last.t << "\t"
+                       << std::setprecision(2) << last.x << "\t" << last.y << "\t"
+                       << std::setprecision(3) << last.V << "\t" << last.theta_c << "\t"
+                       << std::setprecision(2) << last.m << "\n";
+            const double values[6] = {last.t, last.x, last.y, last.V, last.theta_c, last.m};
+            for (int k = 0; k < 6; ++k) summary[k].add(values[k]);
+        }
+    }
+
+    std::ofstream summary_file(summary_name + ".tmp", std::ios::trunc);
+    summary_file << "cases\t" << completed << "\nfailed\t" << failed << "\n"
+                 << "value\tmean\tmin\tmax\n" << std::setprecision(17);
+    for (int k = 0; k < 6; ++k) {
+        summary_file << names[k] << "\t";
+        if (summary[k].count == 0) {
+            summary_file << "nan\tnan\tnan\n";
+            continue;
+        }
+        summary_file << summary[k].mean << "\t"
+                     << summary[k].min << "\t" << summary[k].max << "\n";
+    }
+
+    end_states.flush();
+    trajectories.flush();
+    summary_file.flush();
+    if (!end_states || !trajectories || !summary_file) {
+        std::cerr << "Ошибка записи файлов результата в " << directory << "\n";
+        return false;
+    }
+    end_states.close();
+    trajectories.close();
+    summary_file.close();
+    bool ok = replace_file(end_states_name + ".tmp", end_states_name);
+    ok = replace_file(trajectories_name + ".tmp", trajectories_name) && ok;
+    ok = replace_file(summary_name + ".tmp", summary_name) && ok;
+
+    if (report != nullptr) {
+        report->cases = completed;
+        report->failed_cases = failed;
+    }
+    return ok;
+}
+
+bool runShardedBatch(const std::string& executable, const std::string& cases_file,
+                     const std::vector<BatchCase>& cases, const ShardOptions& options,
+                     ShardReport* report) {
+    ShardReport local;
+    ShardReport& r = report != nullptr ? *report : local;
+    if (options.shards == 0) {
+        std::cerr << "Число шардов должно быть больше нуля\n";
+        return false;
+    }
+    const unsigned long long fingerprint = shardFingerprint(cases, options.batch_arguments);
+    std::error_code error;
+    std::filesystem::create_directories(options.directory + "/shards", error);
+
+    // Готовые файлы (прежний запуск или исполнители на других машинах) не пересчитываются
+    std::deque<unsigned> queue;
+    for (unsigned shard = 0; shard < options.shards; ++shard) {
+        if (shardFileValid(shardFileName(options.directory, shard, options.shards), fingerprint,
+                           cases.size(), shard, options.shards)) {
+            ++r.reused;
+        } else {
+            queue.push_back(shard);
+        }
+    }
+
+#ifdef _WIN32
+    (void)executable;
+    (void)cases_file;
+    if (!queue.empty()) {
+        std::cerr << "Запуск исполнителей поддерживается только в POSIX; запустите "
+                     "--batch-worker для недостающих шардов вручную\n";
+        return false;
+    }
+#else
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    unsigned workers = options.workers > 0 ? options.workers : hardware;
+    workers = std::max(1u, std::min(workers, options.shards));
+
+    // Потоки исполнителя делят ядра поровну, если --threads не задан
+    std::vector<std::string> worker_arguments = options.batch_arguments;
+    bool has_threads = false;
+    for (size_t i = 0; i < worker_arguments.size(); i += 2) {
+        has_threads = has_threads || worker_arguments[i] == "--threads";
+    }
+    if (!has_threads) {
+        worker_arguments.push_back("--threads");
+        worker_arguments.push_back(std::to_string(std::max(1u, hardware / workers)));
+    }
+
+    std::vector<unsigned> attempts(options.shards, 0);
+    std::vector<std::pair<pid_t, unsigned>> running;
+    bool ok = true;
+
+    auto launch = [&](unsigned shard) {
+        ++attempts[shard];
+        ++r.launched;
+        std::vector<std::string> args = {executable, "--batch-worker", cases_file,
+                                         "--shard", std::to_string(shard) + "/" + std::to_string(options.shards),
+                                         "--out", options.directory};
+        args.insert(args.end(), worker_arguments.begin(), worker_arguments.end());
+#ifdef TRAJECTORY_FAULT_INJECTION
+        const std::string attempt = std::to_string(attempts[shard]);
+#endif
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            std::vector<char*> argv;
+            for (std::string& arg : args) argv.push_back(&arg[0]);
+            argv.push_back(nullptr);
+#ifdef TRAJECTORY_FAULT_INJECTION
+            setenv("TRAJECTORY_SHARD_ATTEMPT", attempt.c_str(), 1);
+#endif
+            execv(executable.c_str(), argv.data());
+            std::perror("execv");
+            _exit(127);
+        }
+        if (pid < 0) {
+            std::perror("fork");
+            return false;
+        }
+        running.emplace_back(pid, shard);
+        return true;
+    };
+
+    while (ok && (!queue.empty() || !running.empty())) {
+        while (!queue.empty() && running.size() < workers) {
+            unsigned shard = queue.front();
+            queue.pop_front();
+            if (!launch(shard)) {
+                ok = false;
+                break;
+            }
+        }
+        if (running.empty()) break;
+
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0) {
+            std::perror("waitpid");
+            ok = false;
+            break;
+        }
+        auto it = std::find_if(running.begin(), running.end(),
+                               [pid](const std::pair<pid_t, unsigned>& item) { return item.first == pid; });
+        if (it == running.end()) continue;
+        const unsigned shard = it->second;
+        running.erase(it);
+
+        const bool exited = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        if (exited && shardFileValid(shardFileName(options.directory, shard, options.shards), fingerprint,
+                                     cases.size(), shard, options.shards)) {
+            continue;
+        }
+        std::cerr << "Шард " << shard << ": исполнитель завершился ";
+        if (WIFSIGNALED(status)) std::cerr << "по сигналу " << WTERMSIG(status);
+        else std::cerr << "с кодом " << (WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+        if (attempts[shard] <= options.retries) {
+            std::cerr << ", повтор " << attempts[shard] << " из " << options.retries << "\n";
+            ++r.retried;
+            queue.push_back(shard);
+        } else {
+            std::cerr << ", повторы исчерпаны\n";
+            ok = false;
+        }
+    }
+
+    // При ошибке дожидаемся запущенных, чтобы не оставлять процессы
+    for (const auto& item : running) {
+        int status = 0;
+        waitpid(item.first, &status, 0);
+    }
+    if (!ok) return false;
+#endif
+
+    return mergeShards(cases, options.shards, fingerprint, options.directory, &r);
+}
@@ -0,0 +1,307 @@
+#include "surrogate.h"
+#include "trajectory_table.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace {
+
+// meta[0]: признак и версия формата таблицы
+const std::uint64_t SURROGATE_FORMAT = 0x5355524702ULL;   // "SURG", версия 2 (ошибки по компонентам)
+
+const size_t STATE_COMPONENTS = TrajectorySurrogate::STATE_COMPONENTS;
+
+// Базовый случай без имени и значений полей сетки - ключ соответствия таблицы
+unsigned long long base_fingerprint(const BatchCase& base, const std::vector<size_t>& fields) {
+    BatchCase key = base;
+    key.name.clear();
+    for (size_t field : fields) vehicleField(key.params, field) = 0.0;
+    return batchFingerprint(std::vector<BatchCase>(1, key));
+}
+
+double node_coordinate(const SurrogateAxis& axis, size_t i) {
+    if (i + 1 == axis.nodes) return axis.max;
+    return axis.min + (axis.max - axis.min) * static_cast<double>(i) / static_cast<double>(axis.nodes - 1);
+}
+
+void store_end_state(const TrajectoryPoint& point, double* out) {
+    out[0] = point.t;
+    out[1] = point.x;
+    out[2] = point.y;
+    out[3] = point.V;
+    out[4] = point.theta_c;
+    out[5] = point.m;
+}
+
+SurrogateState make_state(const double* values) {
+    SurrogateState state;
+    state.t = values[0];
+    state.x = values[1];
+    state.y = values[2];
+    state.V = values[3];
+    state.theta_c = values[4];
+    state.m = values[5];
+    return state;
+}
+
+} // namespace
+
+std::vector<SurrogateAxis> loadSurrogateGrid(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        throw std::runtime_error("Ошибка открытия файла сетки: " + filename);
+    }
+
+    std::vector<SurrogateAxis> axes;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        std::istringstream in(line);
+        SurrogateAxis axis;
+        if (!(in >> axis.field >> axis.min >> axis.max >> axis.nodes)) {
+            throw std::runtime_error("Ошибка разбора " + filename + ", строка " +
+                                     std::to_string(line_number));
+        }
+        axes.push_back(axis);
+    }
+    return axes;
+}
+
+bool TrajectorySurrogate::build(const BatchCase& base, const std::vector<SurrogateAxis>& axes, unsigned threads,
+                                TrajectorySurrogate& surrogate, SurrogateBuildReport* report) {
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    if (axes.empty() || axes.size() > LookupTable::MAX_DIMS) {
+        throw std::invalid_argument("Суррогат: число осей должно быть от 1 до " +
+                                    std::to_string(LookupTable::MAX_DIMS));
+    }
+
+    // Оси в порядке полей VehicleParams - порядок не зависит от файла сетки
+    std::vector<SurrogateAxis> grid = axes;
+    for (const SurrogateAxis& axis : grid) {
+        if (vehicleFieldIndex(axis.field) == VEHICLE_FIELD_COUNT) {
+            throw std::invalid_argument("Суррогат: неизвестный параметр " + axis.field);
+        }
+        if (axis.nodes < 2 || !(axis.max > axis.min)) {
+            throw std::invalid_argument("Суррогат: для " + axis.field + " нужны min < max и не меньше 2 узлов");
+        }
+    }
+    std::sort(grid.begin(), grid.end(), [](const SurrogateAxis& a, const SurrogateAxis& b) {
+        return vehicleFieldIndex(a.field) < vehicleFieldIndex(b.field);
+    });
+    std::vector<size_t> fields;
+    for (const SurrogateAxis& axis : grid) {
+        if (!fields.empty() && fields.back() == vehicleFieldIndex(axis.field)) {
+            throw std::invalid_argument("Суррогат: ось " + axis.field + " задана повторно");
+        }
+        fields.push_back(vehicleFieldIndex(axis.field));
+    }
+
+    const size_t dims = grid.size();
+    std::vector<std::vector<double>> nodes(dims);
+    std::vector<size_t> strides(dims);
+    size_t node_count = 1, cell_count = 1;
+    for (size_t d = dims; d-- > 0;) {
+        strides[d] = node_count;
+        node_count *= grid[d].nodes;
+        cell_count *= grid[d].nodes - 1;
+        for (size_t i = 0; i < grid[d].nodes; ++i) {
+            nodes[d].push_back(node_coordinate(grid[d], i));
+        }
+    }
+
+    // Случаи: сначала узлы сетки, затем центры ячеек
+    std::vector<BatchCase> cases;
+    cases.reserve(node_count + cell_count);
+    std::vector<size_t> cell_corner(cell_count);
+    for (size_t node = 0; node < node_count; ++node) {
+        BatchCase c = base;
+        c.name = "node_" + std::to_string(node);
+        for (size_t d = 0; d < dims; ++d) {
+            vehicleField(c.params, fields[d]) = nodes[d][node / strides[d] % grid[d].nodes];
+        }
+        cases.push_back(c);
+    }
+    for (size_t cell = 0; cell < cell_count; ++cell) {
+        BatchCase c = base;
+        c.name = "cell_" + std::to_string(cell);
+        size_t rest = cell, corner = 0;
+        for (size_t d = dims; d-- > 0;) {
+            size_t i = rest % (grid[d].nodes - 1);
+            rest /= grid[d].nodes - 1;
+            corner += i * strides[d];
+            vehicleField(c.params, fields[d]) = 0.5 * (nodes[d][i] + nodes[d][i + 1]);
+        }
+        cell_corner[cell] = corner;
+        cases.push_back(c);
+    }
+
+    // Каждый случай пишет только свою строку - синхронизация не нужна
+    std::vector<double> end_states(cases.size() * STATE_COMPONENTS, 0.0);
+    std::vector<unsigned char> failed(cases.size(), 0);
+    BatchOptions options;
+    options.threads = threads;
+    runBatch(cases, options, [&](unsigned, size_t index, const std::vector<TrajectoryPoint>& trajectory) {
+        if (trajectory.empty()) {
+            failed[index] = 1;
+            return;
+        }
+        store_end_state(trajectory.back(), &end_states[index * STATE_COMPONENTS]);
+    });
+    for (size_t i = 0; i < cases.size(); ++i) {
+        if (failed[i]) {
+            std::cerr << "Суррогат: случай " << formatBatchCase(cases[i]) << " не рассчитан" << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<double> values(node_count * COMPONENTS, 0.0);
+    for (size_t node = 0; node < node_count; ++node) {
+        std::copy(&end_states[node * STATE_COMPONENTS], &end_states[(node + 1) * STATE_COMPONENTS],
+                  &values[node * COMPONENTS]);
+    }
+
+    // Карты ошибок: точное конечное состояние в центре ячейки против интерполяции по узлам
+    SurrogateBuildReport result;
+    {
+        LookupTable nodes_only(nodes, COMPONENTS, values);
+        std::vector<double> x(dims), interpolated(COMPONENTS);
+        double max_error[STATE_COMPONENTS] = {}, mean_error[STATE_COMPONENTS] = {};
+        for (size_t cell = 0; cell < cell_count; ++cell) {
+            const BatchCase& c = cases[node_count + cell];
+            for (size_t d = 0; d < dims; ++d) x[d] = vehicleField(c.params, fields[d]);
+            nodes_only.interpolate(x.data(), interpolated.data());
+            const double* exact = &end_states[(node_count + cell) * STATE_COMPONENTS];
+            for (size_t k = 0; k < STATE_COMPONENTS; ++k) {
+                double error = std::fabs(exact[k] - interpolated[k]);
+                if (!(error == error)) error = std::numeric_limits<double>::infinity();
+                values[cell_corner[cell] * COMPONENTS + STATE_COMPONENTS + k] = error;
+                max_error[k] = std::max(max_error[k], error);
+                mean_error[k] += error / static_cast<double>(cell_count);
+            }
+        }
+        result.max_error = make_state(max_error);
+        result.mean_error = make_state(mean_error);
+    }
+
+    surrogate.base = base;
+    surrogate.grid = grid;
+    surrogate.fields = fields;
+    surrogate.table = LookupTable(nodes, COMPONENTS, values);
+
+    result.nodes = node_count;
+    result.cells = cell_count;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    if (report != nullptr) *report = result;
+    return true;
+}
+
+bool TrajectorySurrogate::save(const std::string& filename) const {
+    std::uint64_t mask = 0;
+    for (size_t field : fields) mask |= std::uint64_t(1) << field;
+    LookupTable::Meta meta = {{SURROGATE_FORMAT, mask, base_fingerprint(base, fields), 0}};
+    return table.saveBinary(filename, meta);
+}
+
+bool TrajectorySurrogate::load(const std::string& filename, const BatchCase& base, TrajectorySurrogate& surrogate) {
+    LookupTable table;
+    LookupTable::Meta meta;
+    if (!LookupTable::mapBinary(filename, table, meta) || meta[0] != SURROGATE_FORMAT
+        || table.components() != COMPONENTS) {
+        return false;
+    }
+
+    std::vector<size_t> fields;
+    for (size_t field = 0; field < VEHICLE_FIELD_COUNT; ++field) {
+        if ((meta[1] >> field) & 1u) fields.push_back(field);
+    }
+    if (fields.size() != table.dims() || meta[2] != base_fingerprint(base, fields)) {
+        return false;
+    }
+
+    std::vector<SurrogateAxis> grid;
+    for (size_t d = 0; d < fields.size(); ++d) {
+        SurrogateAxis axis;
+        axis.field = vehicleFieldName(fields[d]);
+        axis.nodes = table.axisSize(d);
+        axis.min = table.axis(d)[0];
+        axis.max = table.axis(d)[axis.nodes - 1];
+        if (axis.nodes < 2) return false;
+        grid.push_back(axis);
+    }
+
+    surrogate.base = base;
+    surrogate.grid = grid;
+    surrogate.fields = fields;
+    surrogate.table = table;
+    return true;
+}
+
+bool TrajectorySurrogate::cellError(const VehicleParams& params, SurrogateState& error) const {
+    if (table.empty()) return false;
+
+    // Остальные поля должны совпадать с базовым случаем
+    size_t d = 0;
+    for (size_t field = 0; field < VEHICLE_FIELD_COUNT; ++field) {
+        if (d < fields.size() && fields[d] == field) {
+            ++d;
+        } else if (vehicleField(params, field) != vehicleField(base.params, field)) {
+            return false;
+        }
+    }
+
+    // Сетка равномерная - номер ячейки без поиска
+    size_t node = 0;
+    for (d = 0; d < fields.size(); ++d) {
+        const SurrogateAxis& axis = grid[d];
+        double x = vehicleField(params, fields[d]);
+        if (!(x >= axis.min && x <= axis.max)) return false;
+        double position = (x - axis.min) / (axis.max - axis.min) * static_cast<double>(axis.nodes - 1);
+        size_t i = std::min(static_cast<size_t>(position), axis.nodes - 2);
+        node += i * table.stride(d);
+    }
+    error = make_state(&table.values()[node * COMPONENTS + STATE_COMPONENTS]);
+    return true;
+}
+
+SurrogateState TrajectorySurrogate::evaluate(const VehicleParams& params, const SurrogateTolerance& tolerance,
+                                             bool* from_table) const {
+    SurrogateState error;
+    const bool use_table = cellError(params, error) && error.t <= tolerance.t &&
+                           error.x <= tolerance.position && error.y <= tolerance.position &&
+                           error.V <= tolerance.V && error.theta_c <= tolerance.theta_c && error.m <= tolerance.m;
+    if (from_table != nullptr) *from_table = use_table;
+
+    if (use_table) {
+        double x[LookupTable::MAX_DIMS];
+        double out[COMPONENTS];
+        for (size_t d = 0; d < fields.size(); ++d) x[d] = vehicleField(params, fields[d]);
+        table.interpolate(x, out);
+        return make_state(out);
+    }
+
+    // Вне применимости таблицы - обычный расчёт; нужна только конечная точка,
+    // поэтому траектория пишется в столбцы без производных величин
+    thread_local TrajectoryTable trajectory(channelBit(CHANNEL_T) | channelBit(CHANNEL_X) | channelBit(CHANNEL_Y)
+                                            | channelBit(CHANNEL_V) | channelBit(CHANNEL_THETA_C)
+                                            | channelBit(CHANNEL_MASS));
+    TrajectoryCalculator calculator(params);
+    if (!calculator.calculateTrajectory(base.method, base.alpha_law, base.dt, trajectory) || trajectory.empty()) {
+        throw std::runtime_error("Суррогат: расчёт траектории не выполнен");
+    }
+    const size_t last = trajectory.size() - 1;
+    double out[STATE_COMPONENTS] = {
+        trajectory.column(CHANNEL_T)[last], trajectory.column(CHANNEL_X)[last],
+        trajectory.column(CHANNEL_Y)[last], trajectory.column(CHANNEL_V)[last],
+        trajectory.column(CHANNEL_THETA_C)[last], trajectory.column(CHANNEL_MASS)[last]
+    };
+    return make_state(out);
+}
@@ -1,9 +1,17 @@
 #include "trajectory.h"
+#include "downsampling.h"
+#include "atmosphere_profile.h"
+#include "aero_database.h"
+#include "trajectory_table.h"
+#include "kernels.h"
+#include "atmosphere_model.h"
 #include <iostream>
 #include <fstream>
 #include <iomanip>
 #include <cmath>
 #include <algorithm>
+#include <utility>
+#include <stdexcept>
 
 // Глобальные аэродинамические таблицы
 std::vector<double> M_table = {0.01, 0.55, 0.8, 0.9, 1.0, 1.06, 1.1, 1.2, 
@@ -24,6 +32,25 @@ double rad2deg(double rad) {
     return rad * 180.0 / M_PI;
 }
 
+// Воздушная скорость с учётом горизонтального ветра вдоль оси x
+double airspeed(double V, double sin_theta_c, double cos_theta_c, double wind) {
+    if (wind == 0.0) return V;
+    double u = V * cos_theta_c - wind;
+    double v = V * sin_theta_c;
+    return sqrt(u * u + v * v);
+}
+
+double airspeed(double V, double theta_c_rad, double wind) {
+    if (wind == 0.0) return V;
+    return airspeed(V, sin(theta_c_rad), cos(theta_c_rad), wind);
+}
+
+// Учёт обращения к моделям атмосферы и аэродинамики при числе Маха M на высоте y
+void widen_envelope(FlightEnvelope& envelope, double M, double y) {
+    if (M > envelope.max_mach) envelope.max_mach = M;
+    if (y > envelope.max_altitude) envelope.max_altitude = y;
+}
+
 double interpolate_linear(double x, const std::vector<double>& x_vals, 
                          const std::vector<double>& y_vals) {
     if (x <= x_vals.front()) return y_vals.front();
@@ -38,6 +65,59 @@ double interpolate_linear(double x, const std::vector<double>& x_vals,
     return y_vals.back();
 }
 
+// Интервал x_i < x <= x_{i+1} (его же находит interpolate_linear); поиск от интервала hint.
+// x должен лежать строго внутри таблицы
+size_t find_interval(double x, const std::vector<double>& x_vals, size_t hint) {
+    const size_t last = x_vals.size() - 2;
+    size_t i = hint > last ? last : hint;
+    while (i > 0 && x <= x_vals[i]) --i;
+    while (i < last && x > x_vals[i+1]) ++i;
+    return i;
+}
+
+// То же, что interpolate_linear; interval - курсор интервала предыдущего вызова
+double interpolate_linear(double x, const std::vector<double>& x_vals,
+                         const std::vector<double>& y_vals, size_t& interval) {
+    if (x <= x_vals.front()) return y_vals.front();
+    if (x >= x_vals.back()) return y_vals.back();
+    if (x != x) return y_vals.back();  // NaN
+    
+    size_t i = find_interval(x, x_vals, interval);
+    interval = i;
+    double t = (x - x_vals[i]) / (x_vals[i+1] - x_vals[i]);
+    return y_vals[i] + t * (y_vals[i+1] - y_vals[i]);
+}
+
+// Точки траектории с шагом 0.1 секунды (с небольшой погрешностью для плавающих чисел),
+// при заданных допусках - дополнительно прореженные; filtered_count - число точек до прореживания
+std::vector<const TrajectoryPoint*> select_saved_points(const std::vector<TrajectoryPoint>& trajectory,
+                                                        const DownsampleTolerance* tolerance,
+                                                        size_t& filtered_count) {
+    std::vector<const TrajectoryPoint*> points;
+    for (const auto& p : trajectory) {
+        double remainder = fmod(p.t + 1e-9, 0.1);
+        if (remainder < 1e-6 || remainder > 0.099999) {
+            points.push_back(&p);
+        }
+    }
+    filtered_count = points.size();
+    
+    if (tolerance != nullptr) {
+        std::vector<const TrajectoryPoint*> reduced;
+        for (size_t i : downsampleIndices(points, *tolerance)) {
+            reduced.push_back(points[i]);
+        }
+        points.swap(reduced);
+    }
+    return points;
+}
+
+// Пояснение к сообщению о сохранении
+std::string saved_points_note(size_t saved, size_t total, const DownsampleTolerance* tolerance) {
+    if (tolerance == nullptr) return "шаг 0.1с";
+    return "шаг 0.1с, прорежено: " + std::to_string(saved) + " из " + std::to_string(total) + " точек";
+}
+
 double interpolate_Cxa(double M) {
     return interpolate_linear(M, M_table, Cxa_table);
 }
@@ -46,6 +126,15 @@ double interpolate_Cya_alpha(double M) {
     return interpolate_linear(M, M_table, Cya_alpha_table);
 }
 
+// Обе таблицы заданы на M_table, поэтому курсор у них общий
+double interpolate_Cxa(double M, size_t& interval) {
+    return interpolate_linear(M, M_table, Cxa_table, interval);
+}
+
+double interpolate_Cya_alpha(double M, size_t& interval) {
+    return interpolate_linear(M, M_table, Cya_alpha_table, interval);
+}
+
 // Конструктор TrajectoryCalculator
 TrajectoryCalculator::TrajectoryCalculator(double V0, double theta_c0, double m_dot, double W,
                                           double y0, double omega_z0, double theta0,
@@ -55,11 +144,59 @@ TrajectoryCalculator::TrajectoryCalculator(double V0, double theta_c0, double m_
       t_end(t_end), m0(m0), I_d(I_d), S_a(S_a), S_m(S_m) {
 }
 
+TrajectoryCalculator::TrajectoryCalculator(const VehicleParams& p)
+    : TrajectoryCalculator(p.V0, p.theta_c0, p.m_dot, p.W, p.y0, p.omega_z0, p.theta0,
+                           p.t_end, p.m0, p.I_d, p.S_a, p.S_m) {
+}
+
+void TrajectoryCalculator::setAtmosphereProfile(std::shared_ptr<const AtmosphereProfile> profile) {
+    atmosphere_profile = std::move(profile);
+}
+
+void TrajectoryCalculator::setAeroDatabase(std::shared_ptr<const AeroDatabase> database) {
+    aero_database = std::move(database);
+}
+
+void TrajectoryCalculator::setPitchDynamics(const PitchDynamics& dynamics) {
+    if (dynamics.enabled && (dynamics.I_z0 <= 0.0 || dynamics.L <= 0.0)) {
+        throw std::invalid_argument("Динамика тангажа: I_z0 и L должны быть положительными");
+    }
+    pitch = dynamics;
+}
+
+void TrajectoryCalculator::setFastMath(bool enabled) {
+    fast_math = enabled;
+}
+
+// Высота в области модели атмосферы: там atmosphereAt не бросает исключений
+bool TrajectoryCalculator::atmosphereCovers(double y) const {
+    if (atmosphere_profile && y >= atmosphere_profile->minAltitude() && y <= atmosphere_profile->maxAltitude()) {
+        return true;
+    }
+    return !(y < atmosphere_model::H_MIN || y > atmosphere_model::H_MAX);
+}
+
+// Параметры атмосферы на высоте y; wind - попутный ветер (только у профиля)
+AtmosphereParams TrajectoryCalculator::atmosphereAt(double y, double& wind, LookupCursors& cursors) const {
+    wind = 0.0;
+    if (atmosphere_profile) {
+        return atmosphere_profile->evaluate(y, &wind);
+    }
+    if (fast_math) {
+        return calculate_atmosphere_fast(y, &cursors.atmosphere);
+    }
+    return calculate_atmosphere_cursor(y, &cursors.atmosphere);
+}
+
+VehicleParams TrajectoryCalculator::params() const {
+    return VehicleParams{V0, theta_c0, m_dot, W, y0, omega_z0, theta0,
+                         t_end, m0, I_d, S_a, S_m};
+}
+
 // Добавление точки траектории (ИСПРАВЛЕННАЯ ВЕРСИЯ)
-void TrajectoryCalculator::addTrajectoryPoint(std::vector<TrajectoryPoint>& trajectory, double t, 
-                                             const std::vector<double>& state, 
-                                             const std::vector<double>& derivatives,
-                                             AlphaLaw alpha_law) const {
+TrajectoryPoint TrajectoryCalculator::makeTrajectoryPoint(double t, const StateVector& state,
+                                                         const StateVector& derivatives,
+                                                         AlphaLaw alpha_law, LookupCursors& cursors) const {
     TrajectoryPoint point;
     point.t = t;
     point.V = state[0];
@@ -71,16 +208,10 @@ void TrajectoryCalculator::addTrajectoryPoint(std::vector<TrajectoryPoint>& traj
     point.m = state[6];
     
     // Сохраняем производные
-    if (derivatives.size() >= 7) {
-        point.V_dot = derivatives[0];   // dV/dt
-        // point.theta_c_dot = derivatives[1]; // если нужно
-        point.x_dotc = derivatives[2];  // dx/dt
-        point.y_dotc = derivatives[3];  // dy/dt
-    } else {
-        point.V_dot = 0.0;
-        point.x_dotc = 0.0;
-        point.y_dotc = 0.0;
-    }
+    point.V_dot = derivatives[0];   // dV/dt
+    // point.theta_c_dot = derivatives[1]; // если нужно
+    point.x_dotc = derivatives[2];  // dx/dt
+    point.y_dotc = derivatives[3];  // dy/dt
     
     // Тяга (упрощённая формула)
     point.P = m_dot * W;
@@ -88,46 +219,105 @@ void TrajectoryCalculator::addTrajectoryPoint(std::vector<TrajectoryPoint>& traj
     // Защита от отрицательной высоты
     if (point.y < 0) point.y = 0;
     
-    try {
+    // Угол атаки
+    if (alpha_law == ALPHA_THETA_MINUS_THETAC) {
+        point.alpha = point.theta - point.theta_c;
+    } else {
+        point.alpha = 0.0;
+    }
+    
+    if (atmosphereCovers(point.y)) {
         // Параметры атмосферы
-        AtmosphereParams atm = calculate_atmosphere(point.y);
+        double wind;
+        AtmosphereParams atm = atmosphereAt(point.y, wind, cursors);
         point.g = atm.g;
-        point.M = point.V / atm.a;
+        point.M = airspeed(point.V, deg2rad(point.theta_c), wind) / atm.a;
+        widen_envelope(cursors.envelope, point.M, point.y);
         
         // Аэродинамические коэффициенты
-        point.Cxa = interpolate_Cxa(point.M);
-        point.Cya_alpha = interpolate_Cya_alpha(point.M);
-    } catch (const std::exception& e) {
-        // Если ошибка при расчёте атмосферы, используем значения по умолчанию
+        if (aero_database) {
+            aero_database->evaluate(point.M, point.alpha, point.y, point.Cxa, point.Cya_alpha,
+                                    cursors.aero_intervals);
+        } else {
+            point.Cxa = interpolate_Cxa(point.M, cursors.mach_interval);
+            point.Cya_alpha = interpolate_Cya_alpha(point.M, cursors.mach_interval);
+        }
+    } else {
+        // Вне модели атмосферы используем значения по умолчанию
+        widen_envelope(cursors.envelope, 0.0, point.y);
         point.g = 9.80665;
         point.M = point.V / 340.0;  // Примерная скорость звука
         point.Cxa = 0.3;
         point.Cya_alpha = 0.25;
     }
     
-    // Угол атаки
-    if (alpha_law == ALPHA_THETA_MINUS_THETAC) {
-        point.alpha = point.theta - point.theta_c;
-    } else {
-        point.alpha = 0.0;
-    }
+    return point;
+}
+
+TrajectoryPoint TrajectoryCalculator::pointAt(double t, const StateVector& state, AlphaLaw alpha_law,
+                                              LookupCursors* cursors) const {
+    LookupCursors local;
+    LookupCursors& c = cursors != nullptr ? *cursors : local;
+    StateVector derivatives;
+    calculateDerivatives(t, state, derivatives, alpha_law, c);
+    return makeTrajectoryPoint(t, state, derivatives, alpha_law, c);
+}
+
+bool TrajectoryCalculator::aerodynamicColumns(const double* y, const double* V, size_t count,
+                                              double* g, double* M, double* Cxa, double* Cya_alpha) const {
+    if (atmosphere_profile || aero_database || fast_math) return false;
     
-    trajectory.push_back(point);
+    const KernelSet& batch = kernels();
+    const size_t CHUNK = 256;
+    double h[CHUNK], a[CHUNK];
+    
+    for (size_t first = 0; first < count; first += CHUNK) {
+        const size_t n = std::min(CHUNK, count - first);
+        
+        // Как в makeTrajectoryPoint: высота не ниже нуля, без ветра воздушная скорость равна V
+        for (size_t i = 0; i < n; ++i) {
+            h[i] = y[first + i] < 0 ? 0.0 : y[first + i];
+        }
+        AtmosphereColumns atm;
+        atm.a = a;
+        atm.g = g + first;
+        batch.atmosphere(h, n, atm);
+        for (size_t i = 0; i < n; ++i) {
+            M[first + i] = V[first + i] / a[i];
+        }
+        batch.interpolate(M_table.data(), Cxa_table.data(), M_table.size(), M + first, n, Cxa + first);
+        batch.interpolate(M_table.data(), Cya_alpha_table.data(), M_table.size(), M + first, n, Cya_alpha + first);
+        
+        // Выше диапазона атмосферы - значения по умолчанию, как при исключении в makeTrajectoryPoint
+        for (size_t i = 0; i < n; ++i) {
+            if (h[i] > atmosphere_model::H_MAX) {
+                g[first + i] = 9.80665;
+                M[first + i] = V[first + i] / 340.0;
+                Cxa[first + i] = 0.3;
+                Cya_alpha[first + i] = 0.25;
+            }
+        }
+    }
+    return true;
 }
 
 // Расчёт производных (ИСПРАВЛЕННЫЕ УРАВНЕНИЯ)
-void TrajectoryCalculator::calculateDerivatives(double t, const std::vector<double>& state,
-                                               std::vector<double>& derivatives, 
-                                               AlphaLaw alpha_law) const {
+void TrajectoryCalculator::calculateDerivatives(double t, const StateVector& state,
+                                               StateVector& derivatives, 
+                                               AlphaLaw alpha_law, LookupCursors& cursors,
+                                               PitchJacobian* jacobian,
+                                               const ControlCommand* command) const {
     double V = state[0];
     double theta_c = state[1];  // в градусах
     double y = state[3];
     double theta = state[5];    // в градусах
     double m = state[6];
     
-    // Преобразуем углы в радианы
+    // Преобразуем углы в радианы; sin и cos угла наклона нужны несколько раз
     double theta_c_rad = deg2rad(theta_c);
     double theta_rad = deg2rad(theta);
+    double sin_theta_c = sin(theta_c_rad);
+    double cos_theta_c = cos(theta_c_rad);
     
     // Защита от нулевой или отрицательной массы
     if (m <= 0.01 * m0) {
@@ -136,33 +326,49 @@ void TrajectoryCalculator::calculateDerivatives(double t, const std::vector<doub
     
     // Получаем параметры атмосферы
     AtmosphereParams atm;
-    try {
-        atm = calculate_atmosphere(y);
-    } catch (const std::exception& e) {
-        // Используем значения по умолчанию
+    double wind = 0.0;
+    if (atmosphereCovers(y)) {
+        atm = atmosphereAt(y, wind, cursors);
+    } else {
+        // Вне модели атмосферы - значения по умолчанию
         atm.g = 9.80665;
         atm.ro = 1.225;
         atm.a = 340.0;
     }
     
-    // Число Маха и аэродинамические коэффициенты
-    double M = V / atm.a;
-    if (M < 0.01) M = 0.01;
-    if (M > 10.2) M = 10.2;
-    
-    double Cxa = interpolate_Cxa(M);
-    double Cya_alpha_val = interpolate_Cya_alpha(M);
+    // Воздушная скорость (без ветра совпадает с V)
+    double V_air = airspeed(V, sin_theta_c, cos_theta_c, wind);
     
-    // Угол атаки
+    // Угол атаки; заданный командой не зависит от theta
+    const bool alpha_commanded = command != nullptr && command->alpha == command->alpha;
     double alpha_rad;
-    if (alpha_law == ALPHA_THETA_MINUS_THETAC) {
+    if (alpha_commanded) {
+        alpha_rad = deg2rad(command->alpha);
+    } else if (alpha_law == ALPHA_THETA_MINUS_THETAC) {
         alpha_rad = theta_rad - theta_c_rad;
     } else {
         alpha_rad = 0.0;
     }
     
+    // Число Маха и аэродинамические коэффициенты
+    double M = V_air / atm.a;
+    widen_envelope(cursors.envelope, M, y);
+    double Cxa, Cya_alpha_val;
+    if (aero_database) {
+        // База ограничивает аргументы своими осями
+        double alpha_deg = alpha_commanded ? command->alpha
+                         : (alpha_law == ALPHA_THETA_MINUS_THETAC) ? theta - theta_c : 0.0;
+        aero_database->evaluate(M, alpha_deg, y, Cxa, Cya_alpha_val, cursors.aero_intervals);
+    } else {
+        if (M < 0.01) M = 0.01;
+        if (M > 10.2) M = 10.2;
+        
+        Cxa = interpolate_Cxa(M, cursors.mach_interval);
+        Cya_alpha_val = interpolate_Cya_alpha(M, cursors.mach_interval);
+    }
+    
     // Динамическое давление
-    double q = 0.5 * atm.ro * V * V;
+    double q = 0.5 * atm.ro * V_air * V_air;
     
     // Аэродинамические силы
     double Xa = q * S_m * Cxa;
@@ -171,27 +377,51 @@ void TrajectoryCalculator::calculateDerivatives(double t, const std::vector<doub
     // Тяга
     double P = m_dot * W;
     
-    // Производные (ИСПРАВЛЕННЫЕ ФОРМУЛЫ)
-    derivatives.resize(7);
+    double sin_alpha = sin(alpha_rad);
+    double cos_alpha = cos(alpha_rad);
     
+    // Производные (ИСПРАВЛЕННЫЕ ФОРМУЛЫ)
     // dV/dt = (P * cos(alpha) - Xa)/m - g * sin(theta_c)
-    derivatives[0] = (P * cos(alpha_rad) - Xa) / m - atm.g * sin(theta_c_rad);
+    derivatives[0] = (P * cos_alpha - Xa) / m - atm.g * sin_theta_c;
     
     // dtheta_c/dt = (P * sin(alpha) + Ya)/(m * V) - (g * cos(theta_c))/V
     if (V > 1.0) {  // Защита от деления на ноль
-        derivatives[1] = rad2deg((P * sin(alpha_rad) + Ya) / (m * V) - (atm.g * cos(theta_c_rad)) / V);
+        derivatives[1] = rad2deg((P * sin_alpha + Ya) / (m * V) - (atm.g * cos_theta_c) / V);
     } else {
         derivatives[1] = 0.0;
     }
     
     // dx/dt = V * cos(theta_c)
-    derivatives[2] = V * cos(theta_c_rad);
+    derivatives[2] = V * cos_theta_c;
     
     // dy/dt = V * sin(theta_c)
-    derivatives[3] = V * sin(theta_c_rad);
-    
-    // domega_z/dt = 0 (упрощенно)
-    derivatives[4] = 0.0;
+    derivatives[3] = V * sin_theta_c;
+    
+    // domega_z/dt = Mz/I_z (omega_z в тех же единицах, что dtheta/dt - град/с);
+    // без динамики тангажа omega_z постоянна
+    // Заданная командой omega_z выдерживается идеальным приводом
+    const bool omega_commanded = command != nullptr && command->omega_z == command->omega_z;
+    if (pitch.enabled && !omega_commanded) {
+        double I_z = pitch.I_z0 * m / m0;
+        double V_ref = V_air > 1.0 ? V_air : 1.0;
+        double damping = pitch.mz_omegaz * q * S_m * pitch.L * pitch.L / V_ref;  // Н·м·с/рад
+        double Mz = -Ya * I_d + damping * deg2rad(state[4]);
+        derivatives[4] = rad2deg(Mz / I_z);
+        
+        if (jacobian != nullptr) {
+            // alpha = theta - theta_c только при ALPHA_THETA_MINUS_THETAC
+            double restoring = (alpha_law == ALPHA_THETA_MINUS_THETAC && !alpha_commanded)
+                               ? -q * S_m * Cya_alpha_val * I_d : 0.0;
+            jacobian->omega_theta = restoring / I_z;
+            jacobian->omega_omega = damping / I_z;
+        }
+    } else {
+        derivatives[4] = 0.0;
+        if (jacobian != nullptr) {
+            jacobian->omega_theta = 0.0;
+            jacobian->omega_omega = 0.0;
+        }
+    }
     
     // dtheta/dt = omega_z
     derivatives[5] = state[4];
@@ -201,195 +431,271 @@ void TrajectoryCalculator::calculateDerivatives(double t, const std::vector<doub
 }
 
 // Метод Эйлера
-std::vector<TrajectoryPoint> TrajectoryCalculator::integrateEuler(double dt, AlphaLaw alpha_law) const {
-    std::vector<TrajectoryPoint> trajectory;
-    std::vector<double> state = {V0, theta_c0, 0.0, y0, omega_z0, theta0, m0};
-    double t = 0.0;
-    
-    // Начальная точка
-    std::vector<double> initial_derivatives;
-    calculateDerivatives(t, state, initial_derivatives, alpha_law);
-    addTrajectoryPoint(trajectory, t, state, initial_derivatives, alpha_law);
+void TrajectoryCalculator::stepEuler(double t, StateVector& state, double dt, AlphaLaw alpha_law,
+                                          LookupCursors& cursors, const ControlCommand* command) const {
+    StateVector derivatives;
+    calculateDerivatives(t, state, derivatives, alpha_law, cursors, nullptr, command);
     
-    while (t < t_end && state[6] > 0.1 * m0) {
-        std::vector<double> derivatives;
-        calculateDerivatives(t, state, derivatives, alpha_law);
-        
-        // Интегрирование
-        for (size_t i = 0; i < state.size(); ++i) {
-            state[i] += derivatives[i] * dt;
-        }
-        
-        // Защита от отрицательных значений
-        if (state[3] < 0) state[3] = 0;  // Высота не может быть отрицательной
-        if (state[0] < 0) state[0] = 0;  // Скорость не может быть отрицательной
-        
-        t += dt;
-        
-        // Сохраняем точку каждые 0.1 секунды
-        if (fmod(t, 0.1) < dt/2.0 || dt <= 0.1) {
-            std::vector<double> new_derivatives;
-            calculateDerivatives(t, state, new_derivatives, alpha_law);
-            addTrajectoryPoint(trajectory, t, state, new_derivatives, alpha_law);
-        }
+    // Интегрирование
+    for (size_t i = 0; i < state.size(); ++i) {
+        state[i] += derivatives[i] * dt;
     }
+}
+
+// Модифицированный метод Эйлера
+void TrajectoryCalculator::stepModifiedEuler(double t, StateVector& state, double dt, AlphaLaw alpha_law,
+                                          LookupCursors& cursors, const ControlCommand* command) const {
+    StateVector k1, k2;
+    
+    // k1
+    calculateDerivatives(t, state, k1, alpha_law, cursors, nullptr, command);
     
-    // Добавляем конечную точку
-    if (trajectory.empty() || trajectory.back().t < t_end) {
-        std::vector<double> final_derivatives;
-        calculateDerivatives(t, state, final_derivatives, alpha_law);
-        addTrajectoryPoint(trajectory, t, state, final_derivatives, alpha_law);
+    // Промежуточное состояние
+    StateVector state_temp = state;
+    for (size_t i = 0; i < state_temp.size(); ++i) {
+        state_temp[i] += k1[i] * dt;
     }
     
-    return trajectory;
+    // Защита промежуточных значений
+    if (state_temp[3] < 0) state_temp[3] = 0;
+    
+    // k2
+    calculateDerivatives(t + dt, state_temp, k2, alpha_law, cursors, nullptr, command);
+    
+    // Интегрирование
+    for (size_t i = 0; i < state.size(); ++i) {
+        state[i] += (k1[i] + k2[i]) * dt / 2.0;
+    }
 }
 
-// Модифицированный метод Эйлера
-std::vector<TrajectoryPoint> TrajectoryCalculator::integrateModifiedEuler(double dt, AlphaLaw alpha_law) const {
-    std::vector<TrajectoryPoint> trajectory;
-    std::vector<double> state = {V0, theta_c0, 0.0, y0, omega_z0, theta0, m0};
-    double t = 0.0;
+// Метод Рунге-Кутта 4-го порядка
+void TrajectoryCalculator::stepRungeKutta4(double t, StateVector& state, double dt, AlphaLaw alpha_law,
+                                          LookupCursors& cursors, const ControlCommand* command) const {
+    StateVector k1, k2, k3, k4;
+    StateVector state_temp;
     
-    // Начальная точка
-    std::vector<double> initial_derivatives;
-    calculateDerivatives(t, state, initial_derivatives, alpha_law);
-    addTrajectoryPoint(trajectory, t, state, initial_derivatives, alpha_law);
+    // k1
+    calculateDerivatives(t, state, k1, alpha_law, cursors, nullptr, command);
     
-    while (t < t_end && state[6] > 0.1 * m0) {
-        std::vector<double> k1, k2;
-        
-        // k1
-        calculateDerivatives(t, state, k1, alpha_law);
-        
-        // Промежуточное состояние
-        std::vector<double> state_temp = state;
-        for (size_t i = 0; i < state_temp.size(); ++i) {
-            state_temp[i] += k1[i] * dt;
-        }
-        
-        // Защита промежуточных значений
-        if (state_temp[3] < 0) state_temp[3] = 0;
-        
-        // k2
-        calculateDerivatives(t + dt, state_temp, k2, alpha_law);
-        
-        // Интегрирование
-        for (size_t i = 0; i < state.size(); ++i) {
-            state[i] += (k1[i] + k2[i]) * dt / 2.0;
-        }
-        
-        // Защита финальных значений
-        if (state[3] < 0) state[3] = 0;
-        if (state[0] < 0) state[0] = 0;
-        
-        t += dt;
-        
-        if (fmod(t, 0.1) < dt/2.0 || dt <= 0.1) {
-            std::vector<double> new_derivatives;
-            calculateDerivatives(t, state, new_derivatives, alpha_law);
-            addTrajectoryPoint(trajectory, t, state, new_derivatives, alpha_law);
-        }
+    // k2
+    state_temp = state;
+    for (size_t i = 0; i < state_temp.size(); ++i) {
+        state_temp[i] += k1[i] * dt / 2.0;
     }
+    if (state_temp[3] < 0) state_temp[3] = 0;
+    calculateDerivatives(t + dt/2.0, state_temp, k2, alpha_law, cursors, nullptr, command);
     
-    if (trajectory.empty() || trajectory.back().t < t_end) {
-        std::vector<double> final_derivatives;
-        calculateDerivatives(t, state, final_derivatives, alpha_law);
-        addTrajectoryPoint(trajectory, t, state, final_derivatives, alpha_law);
+    // k3
+    state_temp = state;
+    for (size_t i = 0; i < state_temp.size(); ++i) {
+        state_temp[i] += k2[i] * dt / 2.0;
     }
+    if (state_temp[3] < 0) state_temp[3] = 0;
+    calculateDerivatives(t + dt/2.0, state_temp, k3, alpha_law, cursors, nullptr, command);
     
-    return trajectory;
+    // k4
+    state_temp = state;
+    for (size_t i = 0; i < state_temp.size(); ++i) {
+        state_temp[i] += k3[i] * dt;
+    }
+    if (state_temp[3] < 0) state_temp[3] = 0;
+    calculateDerivatives(t + dt, state_temp, k4, alpha_law, cursors, nullptr, command);
+    
+    // Интегрирование
+    for (size_t i = 0; i < state.size(); ++i) {
+        state[i] += (k1[i] + 2.0*k2[i] + 2.0*k3[i] + k4[i]) * dt / 6.0;
+    }
 }
 
-// Метод Рунге-Кутта 4-го порядка
-std::vector<TrajectoryPoint> TrajectoryCalculator::integrateRungeKutta4(double dt, AlphaLaw alpha_law) const {
-    std::vector<TrajectoryPoint> trajectory;
-    std::vector<double> state = {V0, theta_c0, 0.0, y0, omega_z0, theta0, m0};
-    double t = 0.0;
+// Линейно-неявный метод Розенброка ROS2 (Verwer и др.), gamma = 1 + 1/sqrt(2):
+//   (I - gamma*dt*J) k1 = f(y)
+//   (I - gamma*dt*J) k2 = f(y + dt*k1) - 2*k1
+//   y += dt*(3/2*k1 + 1/2*k2)
+// J - аналитический блок тангажа (omega_z, theta), остальные элементы нулевые.
+// Второй порядок сохраняется при любом приближении J (W-метод), а неявная
+// обработка блока тангажа убирает ограничение шага от жёсткого момента.
+// Без динамики тангажа J = 0 и метод совпадает с модифицированным Эйлером.
+void TrajectoryCalculator::stepRosenbrock(double t, StateVector& state, double dt, AlphaLaw alpha_law,
+                                          LookupCursors& cursors, const ControlCommand* command) const {
+    const double gamma = 1.0 + 1.0 / std::sqrt(2.0);
+    
+    StateVector f1, f2, k1, k2;
+    PitchJacobian J;
+    calculateDerivatives(t, state, f1, alpha_law, cursors, &J, command);
+    
+    // Матрица I - gamma*dt*J: единичная вне блока (omega_z = 4, theta = 5)
+    //   [1 - h*J_ww   -h*J_wt] [k_w]   [r_w]
+    //   [-h           1      ] [k_t] = [r_t],  h = gamma*dt
+    const double h = gamma * dt;
+    const double a11 = 1.0 - h * J.omega_omega, a12 = -h * J.omega_theta;
+    const double a21 = -h, a22 = 1.0;
+    const double det = a11 * a22 - a12 * a21;
+    auto solve = [&](const StateVector& rhs, StateVector& k) {
+        k = rhs;
+        k[4] = (rhs[4] * a22 - a12 * rhs[5]) / det;
+        k[5] = (a11 * rhs[5] - a21 * rhs[4]) / det;
+    };
+    
+    solve(f1, k1);
+    
+    StateVector state_temp = state;
+    for (size_t i = 0; i < state_temp.size(); ++i) {
+        state_temp[i] += k1[i] * dt;
+    }
+    if (state_temp[3] < 0) state_temp[3] = 0;
+    calculateDerivatives(t + dt, state_temp, f2, alpha_law, cursors, nullptr, command);
+    
+    for (size_t i = 0; i < f2.size(); ++i) {
+        f2[i] -= 2.0 * k1[i];
+    }
+    solve(f2, k2);
+    
+    // Интегрирование
+    for (size_t i = 0; i < state.size(); ++i) {
+        state[i] += (1.5 * k1[i] + 0.5 * k2[i]) * dt;
+    }
+}
+
+IntegratorState TrajectoryCalculator::initialState(IntegrationMethod method, AlphaLaw alpha_law, double dt) const {
+    IntegratorState st;
+    st.t = 0.0;
+    st.state = {V0, theta_c0, 0.0, y0, omega_z0, theta0, m0};
+    st.method = method;
+    st.alpha_law = alpha_law;
+    st.dt = dt;
+    st.steps = 0;
+    return st;
+}
+
+// Приёмник массива точек: в каждой точке сохранения вычисляются все поля
+struct TrajectoryCalculator::PointSink {
+    const TrajectoryCalculator& calculator;
+    std::vector<TrajectoryPoint>& trajectory;
+    
+    bool empty() const { return trajectory.empty(); }
+    double lastTime() const { return trajectory.back().t; }
+    
+    void add(double t, const StateVector& state, AlphaLaw alpha_law, LookupCursors& cursors) {
+        StateVector derivatives;
+        calculator.calculateDerivatives(t, state, derivatives, alpha_law, cursors);
+        trajectory.push_back(calculator.makeTrajectoryPoint(t, state, derivatives, alpha_law, cursors));
+    }
+    
+    void checkpoint(const CheckpointHook& hook, const IntegratorState& st) {
+        hook.callback(st, trajectory);
+    }
+};
+
+// Приёмник столбцов: сохраняется только состояние
+struct TrajectoryCalculator::TableSink {
+    TrajectoryTable& table;
+    
+    bool empty() const { return table.empty(); }
+    double lastTime() const { return table.lastTime(); }
+    
+    void add(double t, const StateVector& state, AlphaLaw, LookupCursors&) {
+        table.append(t, state);
+    }
+    
+    void checkpoint(const CheckpointHook&, const IntegratorState&) {}
+};
+
+// Общий цикл интегрирования для всех методов
+template <class Sink>
+void TrajectoryCalculator::integrate(IntegratorState& st, Sink& sink, const CheckpointHook* hook,
+                                     unsigned long long stop_step) const {
+    StateVector& state = st.state;
+    const double dt = st.dt;
+    const AlphaLaw alpha_law = st.alpha_law;
+    LookupCursors cursors;
+    cursors.envelope = st.envelope;
     
     // Начальная точка
-    std::vector<double> initial_derivatives;
-    calculateDerivatives(t, state, initial_derivatives, alpha_law);
-    addTrajectoryPoint(trajectory, t, state, initial_derivatives, alpha_law);
+    if (st.steps == 0 && sink.empty()) {
+        sink.add(st.t, state, alpha_law, cursors);
+    }
     
-    while (t < t_end && state[6] > 0.1 * m0) {
-        std::vector<double> k1, k2, k3, k4;
-        std::vector<double> state_temp;
-        
-        // k1
-        calculateDerivatives(t, state, k1, alpha_law);
-        
-        // k2
-        state_temp = state;
-        for (size_t i = 0; i < state_temp.size(); ++i) {
-            state_temp[i] += k1[i] * dt / 2.0;
+    // Номер шага следующего вызова hook (проверка в цикле - одно сравнение)
+    unsigned long long next_hook = (hook != nullptr && hook->interval > 0)
+        ? (st.steps / hook->interval + 1) * hook->interval : ~0ULL;
+    
+    while (st.t < t_end && state[6] > 0.1 * m0 && st.steps < stop_step) {
+        switch (st.method) {
+            case EULER:
+                stepEuler(st.t, state, dt, alpha_law, cursors);
+                break;
+            case MODIFIED_EULER:
+                stepModifiedEuler(st.t, state, dt, alpha_law, cursors);
+                break;
+            case ROSENBROCK:
+                stepRosenbrock(st.t, state, dt, alpha_law, cursors);
+                break;
+            case RUNGE_KUTTA_4:
+            default:
+                stepRungeKutta4(st.t, state, dt, alpha_law, cursors);
+                break;
         }
-        if (state_temp[3] < 0) state_temp[3] = 0;
-        calculateDerivatives(t + dt/2.0, state_temp, k2, alpha_law);
         
-        // k3
-        state_temp = state;
-        for (size_t i = 0; i < state_temp.size(); ++i) {
-            state_temp[i] += k2[i] * dt / 2.0;
-        }
-        if (state_temp[3] < 0) state_temp[3] = 0;
-        calculateDerivatives(t + dt/2.0, state_temp, k3, alpha_law);
+        // Защита от отрицательных значений
+        if (state[3] < 0) state[3] = 0;  // Высота не может быть отрицательной
+        if (state[0] < 0) state[0] = 0;  // Скорость не может быть отрицательной
         
-        // k4
-        state_temp = state;
-        for (size_t i = 0; i < state_temp.size(); ++i) {
-            state_temp[i] += k3[i] * dt;
-        }
-        if (state_temp[3] < 0) state_temp[3] = 0;
-        calculateDerivatives(t + dt, state_temp, k4, alpha_law);
+        st.t += dt;
+        ++st.steps;
         
-        // Интегрирование
-        for (size_t i = 0; i < state.size(); ++i) {
-            state[i] += (k1[i] + 2.0*k2[i] + 2.0*k3[i] + k4[i]) * dt / 6.0;
+        // Сохраняем точку каждые 0.1 секунды
+        if (fmod(st.t, 0.1) < dt/2.0 || dt <= 0.1) {
+            sink.add(st.t, state, alpha_law, cursors);
         }
         
-        // Защита
-        if (state[3] < 0) state[3] = 0;
-        if (state[0] < 0) state[0] = 0;
-        
-        t += dt;
-        
-        if (fmod(t, 0.1) < dt/2.0 || dt <= 0.1) {
-            std::vector<double> new_derivatives;
-            calculateDerivatives(t, state, new_derivatives, alpha_law);
-            addTrajectoryPoint(trajectory, t, state, new_derivatives, alpha_law);
+        if (st.steps == next_hook) {
+            st.envelope = cursors.envelope;
+            sink.checkpoint(*hook, st);
+            next_hook += hook->interval;
         }
     }
     
-    if (trajectory.empty() || trajectory.back().t < t_end) {
-        std::vector<double> final_derivatives;
-        calculateDerivatives(t, state, final_derivatives, alpha_law);
-        addTrajectoryPoint(trajectory, t, state, final_derivatives, alpha_law);
+    // Приостановлен на stop_step: конечная точка добавится при продолжении
+    if (st.steps < stop_step && (sink.empty() || sink.lastTime() < t_end)) {
+        // Добавляем конечную точку
+        sink.add(st.t, state, alpha_law, cursors);
     }
-    
-    return trajectory;
+    st.envelope = cursors.envelope;
+}
+
+void TrajectoryCalculator::continueTrajectory(IntegratorState& st, std::vector<TrajectoryPoint>& trajectory,
+                                              const CheckpointHook* hook,
+                                              unsigned long long stop_step) const {
+    PointSink sink{*this, trajectory};
+    integrate(st, sink, hook, stop_step);
+}
+
+void TrajectoryCalculator::continueTrajectory(IntegratorState& st, TrajectoryTable& table,
+                                              unsigned long long stop_step) const {
+    if (table.empty()) table.clear(st.alpha_law);
+    TableSink sink{table};
+    integrate(st, sink, nullptr, stop_step);
 }
 
 // Сохранение данных для графиков
 void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& trajectory, 
-                                        const std::string& base_filename) const {
+                                        const std::string& base_filename,
+                                        const DownsampleTolerance* tolerance,
+                                        std::ostream& out) const {
     if (trajectory.empty()) {
         std::cerr << "Траектория пуста, данные для графиков не могут быть сохранены\n";
         return;
     }
     
     // Фильтруем точки с шагом 0.1 секунды
-    std::vector<const TrajectoryPoint*> filtered_points;
-    for (const auto& p : trajectory) {
-        double remainder = fmod(p.t + 1e-9, 0.1);
-        if (remainder < 1e-6 || remainder > 0.099999) {
-            filtered_points.push_back(&p);
-        }
-    }
+    size_t filtered_count = 0;
+    std::vector<const TrajectoryPoint*> filtered_points = select_saved_points(trajectory, tolerance, filtered_count);
     
     if (filtered_points.empty()) {
         std::cerr << "Нет точек с шагом 0.1с для сохранения графиков\n";
         return;
     }
+    std::string note = saved_points_note(filtered_points.size(), filtered_count, tolerance);
     
     // 1. V(t) - Скорость от времени
     std::ofstream file_vt(base_filename + "_Vt.txt");
@@ -400,7 +706,7 @@ void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& tra
                    << std::setprecision(3) << p->V << "\n";
         }
         file_vt.close();
-        std::cout << "Данные для графика V(t) сохранены в: " << base_filename + "_Vt.txt (шаг 0.1с)\n";
+        out << "Данные для графика V(t) сохранены в: " << base_filename + "_Vt.txt (" << note << ")\n";
     }
     
     // 2. θ_c(t) - Угол наклона траектории от времени
@@ -412,7 +718,7 @@ void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& tra
                         << std::setprecision(3) << p->theta_c << "\n";
         }
         file_thetact.close();
-        std::cout << "Данные для графика theta_c(t) сохранены в: " << base_filename + "_thetact.txt (шаг 0.1с)\n";
+        out << "Данные для графика theta_c(t) сохранены в: " << base_filename + "_thetact.txt (" << note << ")\n";
     }
     
     // 3. y(t) - Высота от времени
@@ -424,7 +730,7 @@ void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& tra
                    << std::setprecision(2) << p->y << "\n";
         }
         file_yt.close();
-        std::cout << "Данные для графика y(t) сохранены в: " << base_filename + "_yt.txt (шаг 0.1с)\n";
+        out << "Данные для графика y(t) сохранены в: " << base_filename + "_yt.txt (" << note << ")\n";
     }
     
     // 4. x(t) - Дальность от времени
@@ -436,7 +742,7 @@ void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& tra
                    << std::setprecision(2) << p->x << "\n";
         }
         file_xt.close();
-        std::cout << "Данные для графика x(t) сохранены в: " << base_filename + "_xt.txt (шаг 0.1с)\n";
+        out << "Данные для графика x(t) сохранены в: " << base_filename + "_xt.txt (" << note << ")\n";
     }
     
     // 5. ω_z(t) - Угловая скорость от времени
@@ -448,7 +754,7 @@ void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& tra
                         << std::setprecision(4) << p->omega_z << "\n";
         }
         file_omegazt.close();
-        std::cout << "Данные для графика omega_z(t) сохранены в: " << base_filename + "_omegazt.txt (шаг 0.1с)\n";
+        out << "Данные для графика omega_z(t) сохранены в: " << base_filename + "_omegazt.txt (" << note << ")\n";
     }
     
     // 6. θ(t) - Угол тангажа от времени
@@ -460,7 +766,7 @@ void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& tra
                        << std::setprecision(3) << p->theta << "\n";
         }
         file_thetat.close();
-        std::cout << "Данные для графика theta(t) сохранены в: " << base_filename + "_thetat.txt (шаг 0.1с)\n";
+        out << "Данные для графика theta(t) сохранены в: " << base_filename + "_thetat.txt (" << note << ")\n";
     }
     
     // 7. α(t) - Угол атаки от времени
@@ -472,7 +778,7 @@ void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& tra
                        << std::setprecision(3) << p->alpha << "\n";
         }
         file_alphat.close();
-        std::cout << "Данные для графика alpha(t) сохранены в: " << base_filename + "_alphat.txt (шаг 0.1с)\n";
+        out << "Данные для графика alpha(t) сохранены в: " << base_filename + "_alphat.txt (" << note << ")\n";
     }
     
     // 8. V(x) - Скорость от дальности
@@ -484,7 +790,7 @@ void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& tra
                    << std::setprecision(3) << p->V << "\n";
         }
         file_vx.close();
-        std::cout << "Данные для графика V(x) сохранены в: " << base_filename + "_Vx.txt (шаг 0.1с)\n";
+        out << "Данные для графика V(x) сохранены в: " << base_filename + "_Vx.txt (" << note << ")\n";
     }
     
     // 9. θ_c(x) - Угол наклона траектории от дальности
@@ -496,7 +802,7 @@ void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& tra
                         << std::setprecision(3) << p->theta_c << "\n";
         }
         file_thetacx.close();
-        std::cout << "Данные для графика theta_c(x) сохранены в: " << base_filename + "_thetacx.txt (шаг 0.1с)\n";
+        out << "Данные для графика theta_c(x) сохранены в: " << base_filename + "_thetacx.txt (" << note << ")\n";
     }
     
     // 10. y(x) - Высота от дальности (траектория)
@@ -508,7 +814,7 @@ void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& tra
                    << std::setprecision(2) << p->y << "\n";
         }
         file_yx.close();
-        std::cout << "Данные для графика y(x) сохранены в: " << base_filename + "_yx.txt (шаг 0.1с)\n";
+        out << "Данные для графика y(x) сохранены в: " << base_filename + "_yx.txt (" << note << ")\n";
     }
     
     // 11. Сводный файл со всеми параметрами для комплексного анализа
@@ -533,7 +839,7 @@ void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& tra
                         << std::setprecision(4) << p->g << "\n";
         }
         file_summary.close();
-        std::cout << "Сводные данные сохранены в: " << base_filename + "_summary.txt (шаг 0.1с)\n";
+        out << "Сводные данные сохранены в: " << base_filename + "_summary.txt (" << note << ")\n";
     }
 }
 
@@ -541,27 +847,60 @@ void TrajectoryCalculator::saveGraphData(const std::vector<TrajectoryPoint>& tra
 std::vector<TrajectoryPoint> TrajectoryCalculator::calculateTrajectory(IntegrationMethod method, 
                                                                       AlphaLaw alpha_law, 
                                                                       double dt) const {
+    std::vector<TrajectoryPoint> trajectory;
+    calculateTrajectory(method, alpha_law, dt, trajectory);
+    return trajectory;
+}
+
+bool TrajectoryCalculator::calculateTrajectory(IntegrationMethod method, AlphaLaw alpha_law, double dt,
+                                               std::vector<TrajectoryPoint>& trajectory) const {
     try {
-        switch (method) {
-            case EULER:
-                return integrateEuler(dt, alpha_law);
-            case MODIFIED_EULER:
-                return integrateModifiedEuler(dt, alpha_law);
-            case RUNGE_KUTTA_4:
-                return integrateRungeKutta4(dt, alpha_law);
-            default:
-                return integrateRungeKutta4(dt, alpha_law);
-        }
+        trajectory.clear();
+        size_t expected = expectedPointCount(dt);
+        if (trajectory.capacity() < expected) trajectory.reserve(expected);
+        
+        IntegratorState state = initialState(method, alpha_law, dt);
+        continueTrajectory(state, trajectory);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка при расчёте траектории: " << e.what() << std::endl;
+        trajectory.clear();
+        return false;
+    }
+}
+
+bool TrajectoryCalculator::calculateTrajectory(IntegrationMethod method, AlphaLaw alpha_law, double dt,
+                                               TrajectoryTable& table) const {
+    try {
+        table.clear(alpha_law);
+        table.reserve(expectedPointCount(dt));
+        
+        IntegratorState state = initialState(method, alpha_law, dt);
+        continueTrajectory(state, table);
+        return true;
     } catch (const std::exception& e) {
         std::cerr << "Ошибка при расчёте траектории: " << e.what() << std::endl;
-        return std::vector<TrajectoryPoint>();
+        table.clear(alpha_law);
+        return false;
     }
 }
 
+// Точка сохраняется не чаще раза за шаг: начальная, по шагам (с запасом на
+// накопление ошибки в t) и конечная
+size_t TrajectoryCalculator::expectedPointCount(double dt) const {
+    const double MAX_RESERVED_POINTS = 16.0 * 1024 * 1024;
+    if (!(dt > 0.0) || !(t_end > 0.0)) return 2;
+    double steps = std::ceil(t_end / dt) + 1.0;
+    if (steps > MAX_RESERVED_POINTS) return static_cast<size_t>(MAX_RESERVED_POINTS);
+    return static_cast<size_t>(steps) + 2;
+}
+
 // Сохранение результатов в файл
 // Сохранение результатов в файл с шагом 0.1 секунды
 void TrajectoryCalculator::saveResultsToFile(const std::vector<TrajectoryPoint>& trajectory, 
-                                            const std::string& filename) const {
+                                            const std::string& filename,
+                                            const DownsampleTolerance* tolerance,
+                                            std::ostream& out) const {
     std::ofstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Ошибка открытия файла: " << filename << std::endl;
@@ -577,47 +916,46 @@ void TrajectoryCalculator::saveResultsToFile(const std::vector<TrajectoryPoint>&
     int line_count = 1;
     
     // Фильтруем данные с шагом 0.1 секунды
-    for (size_t i = 0; i < trajectory.size(); ++i) {
-        const TrajectoryPoint& p = trajectory[i];
-        
-        // Оставляем только точки с t, кратным 0.1 (с небольшой погрешностью для плавающих чисел)
-        double remainder = fmod(p.t + 1e-9, 0.1);
-        if (remainder < 1e-6 || remainder > 0.099999) {
-            file << line_count++ << "\t"
-                 << std::fixed << std::setprecision(3) << p.t << "\t"
-                 << std::setprecision(2) << p.m << "\t"
-                 << std::setprecision(1) << p.P << "\t"
-                 << std::setprecision(3) << p.V << "\t"
-                 << std::setprecision(4) << p.M << "\t"
-                 << std::setprecision(4) << p.Cxa << "\t"
-                 << std::setprecision(2) << p.alpha << "\t"
-                 << std::setprecision(2) << p.theta_c << "\t"
-                 << std::setprecision(4) << p.Cya_alpha << "\t"
-                 << std::setprecision(4) << p.omega_z << "\t"
-                 << std::setprecision(2) << p.theta << "\t"
-                 << std::setprecision(2) << p.y << "\t"
-                 << std::setprecision(2) << p.x << "\t"
-                 << std::setprecision(4) << p.g << "\t"
-                 << std::setprecision(3) << p.x_dotc << "\t"
-                 << std::setprecision(3) << p.y_dotc << "\t"
-                 << std::setprecision(3) << p.V_dot << "\n";
-        }
+    size_t filtered_count = 0;
+    std::vector<const TrajectoryPoint*> saved_points = select_saved_points(trajectory, tolerance, filtered_count);
+    for (const TrajectoryPoint* point : saved_points) {
+        const TrajectoryPoint& p = *point;
+        file << line_count++ << "\t"
+             << std::fixed << std::setprecision(3) << p.t << "\t"
+             << std::setprecision(2) << p.m << "\t"
+             << std::setprecision(1) << p.P << "\t"
+             << std::setprecision(3) << p.V << "\t"
+             << std::setprecision(4) << p.M << "\t"
+             << std::setprecision(4) << p.Cxa << "\t"
+             << std::setprecision(2) << p.alpha << "\t"
+             << std::setprecision(2) << p.theta_c << "\t"
+             << std::setprecision(4) << p.Cya_alpha << "\t"
+             << std::setprecision(4) << p.omega_z << "\t"
+             << std::setprecision(2) << p.theta << "\t"
+             << std::setprecision(2) << p.y << "\t"
+             << std::setprecision(2) << p.x << "\t"
+             << std::setprecision(4) << p.g << "\t"
+             << std::setprecision(3) << p.x_dotc << "\t"
+             << std::setprecision(3) << p.y_dotc << "\t"
+             << std::setprecision(3) << p.V_dot << "\n";
     }
     
     file.close();
-    std::cout << "Результаты сохранены в файл: " << filename << " (шаг 0.1с)" << std::endl;
+    out << "Результаты сохранены в файл: " << filename << " ("
+              << saved_points_note(saved_points.size(), filtered_count, tolerance) << ")" << std::endl;
 }
 
 // Печать таблицы результатов
-void TrajectoryCalculator::printResultsTable(const std::vector<TrajectoryPoint>& trajectory) const {
+void TrajectoryCalculator::printResultsTable(const std::vector<TrajectoryPoint>& trajectory,
+                                             std::ostream& out) const {
     if (trajectory.empty()) {
-        std::cout << "Траектория пуста!\n";
+        out << "Траектория пуста!\n";
         return;
     }
     
-    std::cout << "\nТАБЛИЦА РЕЗУЛЬТАТОВ РАСЧЁТА ТРАЕКТОРИИ\n";
-    std::cout << "=========================================\n";
-    std::cout << std::setw(4) << "N" 
+    out << "\nТАБЛИЦА РЕЗУЛЬТАТОВ РАСЧЁТА ТРАЕКТОРИИ\n";
+    out << "=========================================\n";
+    out << std::setw(4) << "N" 
               << std::setw(8) << "t(c)" 
               << std::setw(8) << "V(m/s)"
               << std::setw(8) << "V_dot"
@@ -627,7 +965,7 @@ void TrajectoryCalculator::printResultsTable(const std::vector<TrajectoryPoint>&
               << std::setw(8) << "y(m)"
               << std::setw(10) << "x(m)"
               << std::setw(8) << "m(kg)\n";
-    std::cout << std::string(80, '-') << "\n";
+    out << std::string(80, '-') << "\n";
     
     // Выводим каждую 5-ю точку для компактности
     size_t step = trajectory.size() > 25 ? trajectory.size() / 25 : 1;
@@ -635,7 +973,7 @@ void TrajectoryCalculator::printResultsTable(const std::vector<TrajectoryPoint>&
     
     for (size_t i = 0; i < trajectory.size(); i += step) {
         const TrajectoryPoint& p = trajectory[i];
-        std::cout << std::setw(4) << i+1
+        out << std::setw(4) << i+1
                   << std::setw(8) << std::fixed << std::setprecision(1) << p.t
                   << std::setw(8) << std::setprecision(1) << p.V
                   << std::setw(8) << std::setprecision(2) << p.V_dot
@@ -648,14 +986,14 @@ void TrajectoryCalculator::printResultsTable(const std::vector<TrajectoryPoint>&
     }
     
     // Выводим итоговые значения
-    std::cout << "\nИТОГОВЫЕ ЗНАЧЕНИЯ:\n";
+    out << "\nИТОГОВЫЕ ЗНАЧЕНИЯ:\n";
     const TrajectoryPoint& last = trajectory.back();
-    std::cout << "Время полета: " << last.t << " с\n";
-    std::cout << "Конечная скорость: " << last.V << " м/с\n";
-    std::cout << "Конечное ускорение (V_dot): " << last.V_dot << " м/с²\n";
-    std::cout << "Конечная высота: " << last.y << " м\n";
-    std::cout << "Конечная дальность: " << last.x << " м\n";
-    std::cout << "Конечная масса: " << last.m << " кг\n";
-    std::cout << "Горизонтальная скорость (x_dotc): " << last.x_dotc << " м/с\n";
-    std::cout << "Вертикальная скорость (y_dotc): " << last.y_dotc << " м/с\n";
+    out << "Время полета: " << last.t << " с\n";
+    out << "Конечная скорость: " << last.V << " м/с\n";
+    out << "Конечное ускорение (V_dot): " << last.V_dot << " м/с²\n";
+    out << "Конечная высота: " << last.y << " м\n";
+    out << "Конечная дальность: " << last.x << " м\n";
+    out << "Конечная масса: " << last.m << " кг\n";
+    out << "Горизонтальная скорость (x_dotc): " << last.x_dotc << " м/с\n";
+    out << "Вертикальная скорость (y_dotc): " << last.y_dotc << " м/с\n";
 }
\ No newline at end of file
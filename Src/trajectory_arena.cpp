@@ -0,0 +1,17 @@
+#include "trajectory_arena.h"
+
+TrajectoryArena::TrajectoryArena(size_t buffer_count) : buffers(buffer_count) {
+}
+
+std::vector<TrajectoryPoint>& TrajectoryArena::acquire(size_t index, size_t expected_points) {
+    std::vector<TrajectoryPoint>& buffer = buffers[index];
+    prepare(buffer, expected_points);
+    return buffer;
+}
+
+void TrajectoryArena::prepare(std::vector<TrajectoryPoint>& buffer, size_t expected_points) {
+    buffer.clear();
+    if (buffer.capacity() < expected_points) {
+        buffer.reserve(expected_points);
+    }
+}
@@ -0,0 +1,398 @@
+#include "trajectory_server.h"
+#include "trajectory.h"
+#include "batch.h"
+#include "thread_pool.h"
+#include "prefix_cache.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <csignal>
+#include <cerrno>
+#endif
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Задержки последних запросов для оценки перцентилей
+class LatencyStats {
+public:
+    void add(double latency_us) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (window.size() < WINDOW) {
+            window.push_back(latency_us);
+        } else {
+            window[next % WINDOW] = latency_us;
+        }
+        ++next;
+        max_us = std::max(max_us, latency_us);
+    }
+
+    // "count p50_us p99_us max_us"
+    std::string report() const {
+        std::vector<double> sorted;
+        unsigned long long count;
+        double max_value;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sorted = window;
+            count = next;
+            max_value = max_us;
+        }
+        std::sort(sorted.begin(), sorted.end());
+        std::ostringstream out;
+        out << count << std::fixed << std::setprecision(1)
+            << " " << percentile(sorted, 0.50) << " " << percentile(sorted, 0.99) << " " << max_value;
+        return out.str();
+    }
+
+private:
+    static double percentile(const std::vector<double>& sorted, double q) {
+        if (sorted.empty()) return 0.0;
+        size_t index = static_cast<size_t>(q * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    static const size_t WINDOW = 65536;
+    mutable std::mutex mutex;
+    std::vector<double> window;
+    unsigned long long next = 0;
+    double max_us = 0.0;
+};
+
+// Канал ответов одного клиента; закрывается, когда освобождены все ссылки
+class Connection {
+public:
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection();
+
+    void send(const std::string& line);
+
+    const int fd;  // -1 - стандартный вывод
+
+private:
+    std::mutex mutex;
+};
+
+Connection::~Connection() {
+#ifndef _WIN32
+    if (fd >= 0) close(fd);
+#endif
+}
+
+void Connection::send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0) {
+        std::cout << line << '\n' << std::flush;
+        return;
+    }
+#ifndef _WIN32
+    std::string data = line + '\n';
+    const char* ptr = data.data();
+    size_t left = data.size();
+    while (left > 0) {
+        ssize_t written = ::write(fd, ptr, left);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return;  // клиент отключился
+        ptr += written;
+        left -= static_cast<size_t>(written);
+    }
+#endif
+}
+
+// Расчёт по строке запроса; буфер траектории и кэш префиксов у каждого потока свои:
+// повторный запрос с другим t_end продолжается с сохранённого снимка
+std::string compute_response(const std::string& line) {
+    thread_local std::vector<TrajectoryPoint> trajectory;
+    thread_local TrajectoryPrefixCache prefixes;
+
+    BatchCase request;
+    if (!parseBatchCase(line, request)) {
+        std::istringstream in(line);
+        std::string id;
+        in >> id;
+        return id + " ERR неверный формат запроса";
+    }
+
+    try {
+        TrajectoryCalculator calculator(request.params);
+        std::string error;
+        if (!prefixes.calculate(calculator, request.method, request.alpha_law, request.dt, trajectory, &error)) {
+            return request.name + " ERR " + error;
+        }
+    } catch (const std::exception& e) {
+        return request.name + " ERR " + e.what();
+    }
+
+    const TrajectoryPoint& last = trajectory.back();
+    std::ostringstream out;
+    out << request.name << " OK " << std::setprecision(10)
+        << last.t << ' ' << last.x << ' ' << last.y << ' '
+        << last.V << ' ' << last.theta_c << ' ' << last.m;
+    return out.str();
+}
+
+class TrajectoryServer {
+public:
+    explicit TrajectoryServer(unsigned threads) : pool(threads) {}
+
+    // Обработка строки; false - закрыть соединение
+    bool handleLine(const std::shared_ptr<Connection>& connection, std::string line);
+
+    bool stopRequested() const { return stop.load(); }
+    std::string statsReport() const { return stats.report(); }
+    void drain() { pool.wait(); }
+
+    std::atomic<int> listen_fd{-1};
+
+private:
+    ThreadPool pool;
+    LatencyStats stats;
+    std::atomic<bool> stop{false};
+};
+
+bool TrajectoryServer::handleLine(const std::shared_ptr<Connection>& connection, std::string line) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.find_first_not_of(" \t") == std::string::npos) return true;
+
+    if (line == "STATS") {
+        connection->send("STATS " + stats.report());
+        return true;
+    }
+    if (line == "QUIT") {
+        return false;
+    }
+    if (line == "SHUTDOWN") {
+        stop.store(true);
+#ifndef _WIN32
+        int fd = listen_fd.load();
+        if (fd >= 0) ::shutdown(fd, SHUT_RDWR);  // прерывает accept
+#endif
+        return false;
+    }
+
+    Clock::time_point received = Clock::now();
+    pool.submit([this, connection, line, received]() {
+        std::string response = compute_response(line);
+        double latency_us = std::chrono::duration<double, std::micro>(Clock::now() - received).count();
+        stats.add(latency_us);
+        if (response.find(" OK ") != std::string::npos) {
+            std::ostringstream out;
+            out << response << ' ' << std::fixed << std::setprecision(1) << latency_us;
+            response = out.str();
+        }
+        connection->send(response);
+    });
+    return true;
+}
+
+// Прогрев: таблицы атмосферы и аэродинамики, рабочие потоки
+void warm_up() {
+    TrajectoryCalculator calculator(70.5, 40.0, 86.0, 2245.0, 3401.0, 0.035, 40.0,
+                                    3.57, 1255.0, 0.215, 0.14, 0.231);
+    calculator.calculateTrajectory(RUNGE_KUTTA_4, ALPHA_THETA_MINUS_THETAC, 0.1);
+}
+
+int serve_stdin(TrajectoryServer& server) {
+    std::shared_ptr<Connection> connection = std::make_shared<Connection>(-1);
+    std::string line;
+    while (!server.stopRequested() && std::getline(std::cin, line)) {
+        if (!server.handleLine(connection, line)) break;
+    }
+    server.drain();
+    return 0;
+}
+
+#ifndef _WIN32
+void read_connection(TrajectoryServer& server, std::shared_ptr<Connection> connection) {
+    std::string pending;
+    char buffer[4096];
+    for (;;) {
+        ssize_t received = ::read(connection->fd, buffer, sizeof(buffer));
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return;
+        pending.append(buffer, static_cast<size_t>(received));
+
+        size_t start = 0, end;
+        while ((end = pending.find('\n', start)) != std::string::npos) {
+            if (!server.handleLine(connection, pending.substr(start, end - start))) {
+                ::shutdown(connection->fd, SHUT_RD);
+                return;
+            }
+            start = end + 1;
+        }
+        pending.erase(0, start);
+    }
+}
+
+int serve_socket(TrajectoryServer& server, const std::string& path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Слишком длинный путь сокета: " << path << std::endl;
+        return 1;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        std::cerr << "Ошибка создания сокета: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || ::listen(fd, 64) < 0) {
+        std::cerr << "Ошибка привязки сокета " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return 1;
+    }
+    server.listen_fd.store(fd);
+    std::cerr << "Сервер ожидает запросы на " << path << std::endl;
+
+    // Поток чтения на каждое соединение; завершившиеся потоки присоединяются при следующем accept
+    struct Reader {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> finished;
+        std::weak_ptr<Connection> connection;
+    };
+    std::vector<Reader> readers;
+
+    while (!server.stopRequested()) {
+        int client = ::accept(fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        readers.erase(std::remove_if(readers.begin(), readers.end(), [](Reader& reader) {
+            if (!reader.finished->load()) return false;
+            reader.thread.join();
+            return true;
+        }), readers.end());
+
+        Reader reader;
+        std::shared_ptr<Connection> connection = std::make_shared<Connection>(client);
+        reader.finished = std::make_shared<std::atomic<bool>>(false);
+        reader.connection = connection;
+        std::shared_ptr<std::atomic<bool>> finished = reader.finished;
+        reader.thread = std::thread([&server, connection, finished]() {
+            read_connection(server, connection);
+            finished->store(true);
+        });
+        readers.push_back(std::move(reader));
+    }
+
+    // Останов: будим читателей открытых соединений и дожидаемся ответов
+    for (Reader& reader : readers) {
+        if (std::shared_ptr<Connection> connection = reader.connection.lock()) {
+            ::shutdown(connection->fd, SHUT_RD);
+        }
+    }
+    for (Reader& reader : readers) {
+        reader.thread.join();
+    }
+    server.drain();
+    server.listen_fd.store(-1);
+    ::close(fd);
+    ::unlink(path.c_str());
+    return 0;
+}
+#endif
+
+} // namespace
+
+int runTrajectoryServer(const ServerOptions& options) {
+#ifndef _WIN32
+    std::signal(SIGPIPE, SIG_IGN);
+#endif
+    TrajectoryServer server(options.threads);
+    warm_up();
+
+    int code;
+    if (options.socket_path == "-") {
+        code = serve_stdin(server);
+    } else {
+#ifndef _WIN32
+        code = serve_socket(server, options.socket_path);
+#else
+        std::cerr << "Сокеты Unix не поддерживаются на этой платформе, используйте --serve -" << std::endl;
+        code = 1;
+#endif
+    }
+
+    // count p50 p99 max
+    std::cerr << "Задержка запросов (число, p50, p99, max, мкс): " << server.statsReport() << std::endl;
+    return code;
+}
+
+int runTrajectoryClient(const std::string& socket_path, std::istream& in, std::ostream& out) {
+#ifndef _WIN32
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Слишком длинный путь сокета: " << socket_path << std::endl;
+        return 1;
+    }
+    std::strcpy(address.sun_path, socket_path.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "Ошибка подключения к " << socket_path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) ::close(fd);
+        return 1;
+    }
+
+    // Запросы отправляются без ожидания ответов; конец ввода закрывает запись
+    std::thread sender([fd, &in]() {
+        std::string line;
+        while (std::getline(in, line)) {
+            line += '\n';
+            const char* ptr = line.data();
+            size_t left = line.size();
+            while (left > 0) {
+                ssize_t written = ::write(fd, ptr, left);
+                if (written < 0 && errno == EINTR) continue;
+                if (written <= 0) return;
+                ptr += written;
+                left -= static_cast<size_t>(written);
+            }
+        }
+        ::shutdown(fd, SHUT_WR);
+    });
+
+    // Сервер закрывает соединение после ответа на все запросы
+    char buffer[4096];
+    for (;;) {
+        ssize_t received = ::read(fd, buffer, sizeof(buffer));
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) break;
+        out.write(buffer, received);
+    }
+    out.flush();
+    sender.join();
+    ::close(fd);
+    return 0;
+#else
+    (void)socket_path;
+    (void)in;
+    (void)out;
+    std::cerr << "Сокеты Unix не поддерживаются на этой платформе" << std::endl;
+    return 1;
+#endif
+}
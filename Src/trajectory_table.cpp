@@ -0,0 +1,158 @@
+#include "trajectory_table.h"
+#include <sstream>
+#include <stdexcept>
+#include <limits>
+
+namespace {
+
+const char* const CHANNEL_NAMES[CHANNEL_COUNT] = {
+    "t", "V", "theta_c", "x", "y", "omega_z", "theta", "m",
+    "P", "g", "M", "Cxa", "Cya_alpha", "alpha", "x_dotc", "y_dotc", "V_dot"
+};
+
+// Поле точки по каналу: порядок каналов совпадает с порядком полей TrajectoryPoint
+double point_field(const TrajectoryPoint& point, TrajectoryChannel channel) {
+    switch (channel) {
+        case CHANNEL_T: return point.t;
+        case CHANNEL_V: return point.V;
+        case CHANNEL_THETA_C: return point.theta_c;
+        case CHANNEL_X: return point.x;
+        case CHANNEL_Y: return point.y;
+        case CHANNEL_OMEGA_Z: return point.omega_z;
+        case CHANNEL_THETA: return point.theta;
+        case CHANNEL_MASS: return point.m;
+        case CHANNEL_P: return point.P;
+        case CHANNEL_G: return point.g;
+        case CHANNEL_MACH: return point.M;
+        case CHANNEL_CXA: return point.Cxa;
+        case CHANNEL_CYA_ALPHA: return point.Cya_alpha;
+        case CHANNEL_ALPHA: return point.alpha;
+        case CHANNEL_X_DOT: return point.x_dotc;
+        case CHANNEL_Y_DOT: return point.y_dotc;
+        case CHANNEL_V_DOT: return point.V_dot;
+        default: break;
+    }
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+} // namespace
+
+const char* channelName(TrajectoryChannel channel) {
+    return channel < CHANNEL_COUNT ? CHANNEL_NAMES[channel] : "";
+}
+
+bool parseTrajectoryChannels(const std::string& list, unsigned& mask) {
+    mask = 0;
+    std::istringstream in(list);
+    std::string name;
+    while (std::getline(in, name, ',')) {
+        if (name == "state") {
+            mask |= STATE_CHANNELS;
+            continue;
+        }
+        int channel = 0;
+        while (channel < CHANNEL_COUNT && name != CHANNEL_NAMES[channel]) ++channel;
+        if (channel == CHANNEL_COUNT) return false;
+        mask |= channelBit(static_cast<TrajectoryChannel>(channel));
+    }
+    return mask != 0;
+}
+
+TrajectoryTable::TrajectoryTable(unsigned channels)
+    : mask(channels & STATE_CHANNELS) {
+    if ((channels & ~STATE_CHANNELS) != 0) mask = STATE_CHANNELS;
+}
+
+void TrajectoryTable::clear(AlphaLaw law) {
+    for (std::vector<double>& column : columns) column.clear();
+    count = 0;
+    last_t = 0.0;
+    alpha_law = law;
+}
+
+void TrajectoryTable::reserve(size_t points) {
+    for (int c = 0; c <= CHANNEL_MASS; ++c) {
+        if (mask & (1u << c)) columns[c].reserve(points);
+    }
+}
+
+void TrajectoryTable::append(double t, const StateVector& state) {
+    if (mask & channelBit(CHANNEL_T)) columns[CHANNEL_T].push_back(t);
+    for (int c = CHANNEL_V; c <= CHANNEL_MASS; ++c) {
+        // Порядок каналов состояния совпадает с StateVector
+        if (mask & (1u << c)) columns[c].push_back(state[c - CHANNEL_V]);
+    }
+    last_t = t;
+    ++count;
+}
+
+const double* TrajectoryTable::column(TrajectoryChannel channel) const {
+    if (channel > CHANNEL_MASS || !has(channel)) {
+        throw std::invalid_argument(std::string("Канал ") + channelName(channel) + " не хранится в таблице");
+    }
+    return columns[channel].data();
+}
+
+StateVector TrajectoryTable::state(size_t i) const {
+    if (!canDerive()) {
+        throw std::logic_error("Таблица траектории хранит не всё состояние");
+    }
+    StateVector s;
+    for (int c = CHANNEL_V; c <= CHANNEL_MASS; ++c) {
+        s[c - CHANNEL_V] = columns[c][i];
+    }
+    return s;
+}
+
+TrajectoryPoint TrajectoryTable::point(size_t i, const TrajectoryCalculator& calculator) const {
+    return calculator.pointAt(columns[CHANNEL_T][i], state(i), alpha_law);
+}
+
+void TrajectoryTable::derive(TrajectoryChannel channel, const TrajectoryCalculator& calculator,
+                             std::vector<double>& out) const {
+    if (channel <= CHANNEL_MASS && has(channel)) {
+        const double* values = column(channel);
+        out.assign(values, values + count);
+        return;
+    }
+    if (!canDerive()) {
+        throw std::logic_error(std::string("Канал ") + channelName(channel) +
+                               " вычисляется только по всему состоянию");
+    }
+    out.resize(count);
+    
+    // Атмосфера и аэродинамика - пакетно по столбцам y и V, если модели встроенные
+    if (channel == CHANNEL_G || channel == CHANNEL_MACH || channel == CHANNEL_CXA || channel == CHANNEL_CYA_ALPHA) {
+        std::vector<double> fields[4];
+        for (std::vector<double>& field : fields) field.resize(count);
+        if (calculator.aerodynamicColumns(columns[CHANNEL_Y].data(), columns[CHANNEL_V].data(), count,
+                                          fields[0].data(), fields[1].data(), fields[2].data(),
+                                          fields[3].data())) {
+            out.swap(fields[channel - CHANNEL_G]);
+            return;
+        }
+    }
+    
+    LookupCursors cursors;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = point_field(calculator.pointAt(columns[CHANNEL_T][i], state(i), alpha_law, &cursors), channel);
+    }
+}
+
+void TrajectoryTable::toPoints(const TrajectoryCalculator& calculator, std::vector<TrajectoryPoint>& out) const {
+    if (!canDerive()) {
+        throw std::logic_error("Таблица траектории хранит не всё состояние");
+    }
+    out.clear();
+    out.reserve(count);
+    LookupCursors cursors;
+    for (size_t i = 0; i < count; ++i) {
+        out.push_back(calculator.pointAt(columns[CHANNEL_T][i], state(i), alpha_law, &cursors));
+    }
+}
+
+size_t TrajectoryTable::capacityBytes() const {
+    size_t bytes = 0;
+    for (const std::vector<double>& column : columns) bytes += column.capacity() * sizeof(double);
+    return bytes;
+}
@@ -1,10 +1,31 @@
 #include "Include/trajectory.h"
+#include "Include/batch.h"
+#include "Include/trajectory_server.h"
+#include "Include/parareal.h"
+#include "Include/sampling.h"
+#include "Include/surrogate.h"
+#include "Include/async_writer.h"
+#include "Include/kernels.h"
+#include "Include/fast_math.h"
+#include "Include/shard.h"
+#include "Include/ensemble_stats.h"
+#include "Include/realtime_stepper.h"
+#include "Include/result_cache.h"
+#include "Include/downsampling.h"
+#include "Include/trajectory_table.h"
 #include <iostream>
 #include <vector>
 #include <string>
 #include <filesystem>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -12,7 +33,715 @@
 #include <fcntl.h>
 #endif
 
-int main() {
+// Числовое значение параметра key; строка должна быть числом целиком
+// (без знака минус для беззнаковых типов)
+// @return false при ошибке (сообщение в std::cerr)
+template <typename T>
+static bool parse_number(const std::string& key, const std::string& value, T& result) {
+    std::istringstream in(value);
+    T parsed;
+    const bool negative = std::is_unsigned<T>::value && value.find('-') != std::string::npos;
+    if (negative || !(in >> parsed) || !(in >> std::ws).eof()) {
+        std::cerr << "Ошибка: " << key << " ожидает число, получено \"" << value << "\"" << std::endl;
+        return false;
+    }
+    result = parsed;
+    return true;
+}
+
+// Допуски прореживания сохраняемых траекторий: --downsample x,y,V (downsampling.h)
+// @return false при ошибке (сообщение в std::cerr)
+static bool parse_downsample(const std::string& value, DownsampleTolerance& tolerance) {
+    char c1 = 0, c2 = 0;
+    std::istringstream in(value);
+    if (!(in >> tolerance.x >> c1 >> tolerance.y >> c2 >> tolerance.V) || c1 != ',' || c2 != ',' ||
+        !(in >> std::ws).eof() || tolerance.x < 0.0 || tolerance.y < 0.0 || tolerance.V < 0.0) {
+        std::cerr << "Ошибка: --downsample ожидает x,y,V - допуски в м, м, м/с, не меньше 0" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Параметры расчёта пакета, общие для --batch, --sharded и --batch-worker
+// @return false при ошибке (сообщение в std::cerr)
+static bool parse_batch_option(const std::string& key, const std::string& value, BatchOptions& options) {
+    if (key == "--threads") {
+        return parse_number(key, value, options.threads);
+    } else if (key == "--checkpoint") {
+        options.checkpoint_file = value;
+    } else if (key == "--checkpoint-period") {
+        return parse_number(key, value, options.checkpoint_period);
+    } else if (key == "--atmosphere") {
+        try {
+            options.atmosphere = AtmosphereProfile::load(value);
+        } catch (const std::exception& e) {
+            std::cerr << "Ошибка: " << e.what() << std::endl;
+            return false;
+        }
+    } else if (key == "--pitch") {
+        // Динамика тангажа (PitchDynamics в trajectory.h)
+        char c1 = 0, c2 = 0;
+        std::istringstream in(value);
+        PitchDynamics& pitch = options.pitch;
+        if (!(in >> pitch.I_z0 >> c1 >> pitch.L >> c2 >> pitch.mz_omegaz) || c1 != ',' || c2 != ',' ||
+            pitch.I_z0 <= 0.0 || pitch.L <= 0.0) {
+            std::cerr << "Ошибка: --pitch ожидает I_z0,L,mz_omegaz с I_z0 > 0 и L > 0" << std::endl;
+            return false;
+        }
+        pitch.enabled = true;
+    } else if (key == "--aero") {
+        try {
+            options.aero = AeroDatabase::load(value);
+        } catch (const std::exception& e) {
+            std::cerr << "Ошибка: " << e.what() << std::endl;
+            return false;
+        }
+    } else if (key == "--math") {
+        if (value != "exact" && value != "fast") {
+            std::cerr << "Ошибка: --math ожидает exact или fast" << std::endl;
+            return false;
+        }
+        options.fast_math = value == "fast";
+    } else if (key == "--cache" || key == "--cache-size" || key == "--cache-mode") {
+        // Кэш результатов (result_cache.h); параметры применяются к общему объекту
+        ResultCacheOptions cache_options = options.cache ? options.cache->options() : ResultCacheOptions();
+        if (key == "--cache") {
+            cache_options.directory = value;
+        } else if (key == "--cache-size") {
+            std::uint64_t megabytes = 0;
+            if (!parse_number(key, value, megabytes)) return false;
+            if (megabytes == 0 || megabytes > (~std::uint64_t(0) >> 20)) {
+                std::cerr << "Ошибка: --cache-size вне допустимого диапазона" << std::endl;
+                return false;
+            }
+            cache_options.max_bytes = megabytes << 20;
+        } else if (value == "full" || value == "end") {
+            cache_options.trajectories = value == "full";
+        } else {
+            std::cerr << "Ошибка: --cache-mode ожидает full или end" << std::endl;
+            return false;
+        }
+        options.cache = std::make_shared<ResultCache>(cache_options);
+    } else {
+        std::cerr << "Неизвестный параметр: " << key << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Кэш без траекторий (--cache-mode end) годится только потребителям конечного
+// состояния: режимы, сохраняющие траектории, его не принимают
+// @return false при ошибке (сообщение в std::cerr)
+static bool check_trajectory_cache(const BatchOptions& options, const char* mode) {
+    if (options.cache && !options.cache->options().trajectories) {
+        std::cerr << "Ошибка: " << mode << " использует траектории целиком, нужен кэш --cache-mode full" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Пакетный режим:
+//   trajectory_calc --batch cases.txt [--threads N] [--checkpoint file] [--checkpoint-period s]
+//                   [--atmosphere profile.txt] [--aero aero.txt] [--pitch I_z0,L,mz_omegaz]
+//                   [--math exact|fast] [--cache dir] [--cache-size MB] [--downsample x,y,V]
+// Формат строк cases.txt описан в batch.h. С --cache (или --cache-size; каталог по
+// умолчанию results/cache) случаи, уже рассчитанные раньше, берутся из кэша. Кэш
+// только конечных состояний (--cache-mode end) принимает лишь --ensemble без --times. Для каждого случая сохраняется
+// results/batch/<name>.txt, конечные состояния дописываются в results/batch/end_states.txt.
+// С --downsample файлы случаев прореживаются с заданными допусками (downsampling.h).
+static int run_batch_mode(int argc, char* argv[]) {
+    std::string cases_file = argv[2];
+    BatchOptions options;
+    DownsampleTolerance downsample;
+    bool has_downsample = false;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key == "--downsample") {
+            if (!parse_downsample(argv[i + 1], downsample)) {
+                return 1;
+            }
+            has_downsample = true;
+        } else if (!parse_batch_option(key, argv[i + 1], options)) {
+            return 1;
+        }
+    }
+    const DownsampleTolerance* tolerance = has_downsample ? &downsample : nullptr;
+    if (!check_trajectory_cache(options, "--batch")) {
+        return 1;
+    }
+    
+    std::vector<BatchCase> cases;
+    try {
+        cases = loadBatchCases(cases_file);
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    std::filesystem::create_directories("results/batch");
+    std::string end_states_name = "results/batch/end_states.txt";
+    bool new_file = !std::filesystem::exists(end_states_name);
+    std::ofstream end_states(end_states_name, std::ios::app);
+    if (new_file) {
+        end_states << "name\tt(c)\tx(m)\ty(m)\tV(m/s)\ttheta_c(grad)\tm(kg)\n";
+    }
+    
+    std::mutex output_mutex;
+    size_t computed = runBatch(cases, options,
+        [&](unsigned, size_t index, const std::vector<TrajectoryPoint>& trajectory) {
+            const BatchCase& batch_case = cases[index];
+            TrajectoryCalculator calculator(batch_case.params);
+            std::lock_guard<std::mutex> lock(output_mutex);
+            if (trajectory.empty()) {
+                std::cerr << "Траектория " << batch_case.name << " пуста\n";
+                return;
+            }
+            calculator.saveResultsToFile(trajectory, "results/batch/" + batch_case.name + ".txt", tolerance);
+            const TrajectoryPoint& last = trajectory.back();
+            end_states << batch_case.name << "\t" << std::fixed << std::setprecision(3) << last.t << "\t"
+                       << std::setprecision(2) << last.x << "\t" << last.y << "\t"
+                       << std::setprecision(3) << last.V << "\t" << last.theta_c << "\t"
+                       << std::setprecision(2) << last.m << std::endl;
+        });
+    
+    if (options.cache) {
+        ResultCache::Stats stats = options.cache->stats();
+        std::cout << "Пакет: случаев " << cases.size() << ", рассчитано " << computed
+                  << ", из кэша " << stats.hits << "\n"
+                  << "Кэш результатов: записано " << stats.stores << ", вытеснено " << stats.evicted << "\n";
+    } else {
+        std::cout << "Пакет: рассчитано " << computed << " из " << cases.size() << " случаев\n";
+    }
+    return 0;
+}
+
+// Выбранные каналы траекторий по столбцам (trajectory_table.h):
+//   trajectory_calc --columns cases.txt --channels t,x,y,M,Cxa [--out dir]
+//                   [--atmosphere ...] [--aero ...] [--pitch ...] [--math ...]
+// Имена каналов - поля TrajectoryPoint, "state" - всё состояние. Хранятся только
+// выбранные каналы состояния (для производных величин - всё состояние), производные
+// вычисляются после расчёта. Для каждого случая сохраняется <dir>/<name>.tsv
+// (по умолчанию results/columns) и выводится память столбцов.
+static int run_columns_mode(int argc, char* argv[]) {
+    unsigned channels = 0;
+    std::string directory = "results/columns";
+    BatchOptions options;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key == "--channels") {
+            if (!parseTrajectoryChannels(argv[i + 1], channels)) {
+                std::cerr << "Ошибка: неизвестный канал в " << argv[i + 1] << std::endl;
+                return 1;
+            }
+        } else if (key == "--out") {
+            directory = argv[i + 1];
+        } else if (!parse_batch_option(key, argv[i + 1], options)) {
+            return 1;
+        }
+    }
+    if (channels == 0) {
+        std::cerr << "Ошибка: нужен список каналов --channels" << std::endl;
+        return 1;
+    }
+    
+    std::vector<BatchCase> cases;
+    try {
+        cases = loadBatchCases(argv[2]);
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+    std::filesystem::create_directories(directory);
+    
+    std::vector<TrajectoryChannel> selected;
+    for (int c = 0; c < CHANNEL_COUNT; ++c) {
+        if (channels & channelBit(static_cast<TrajectoryChannel>(c))) {
+            selected.push_back(static_cast<TrajectoryChannel>(c));
+        }
+    }
+    
+    // Таблица одна на все случаи: расчёт очищает её с сохранением ёмкости
+    TrajectoryTable table(channels);
+    std::vector<std::vector<double>> columns(selected.size());
+    size_t written = 0;
+    for (const BatchCase& batch_case : cases) {
+        TrajectoryCalculator calculator(batch_case.params);
+        calculator.setAtmosphereProfile(options.atmosphere);
+        calculator.setAeroDatabase(options.aero);
+        calculator.setPitchDynamics(options.pitch);
+        calculator.setFastMath(options.fast_math);
+        if (!calculator.calculateTrajectory(batch_case.method, batch_case.alpha_law, batch_case.dt, table)) {
+            std::cerr << "Траектория " << batch_case.name << " не рассчитана\n";
+            continue;
+        }
+        for (size_t k = 0; k < selected.size(); ++k) {
+            table.derive(selected[k], calculator, columns[k]);
+        }
+        
+        const std::string filename = directory + "/" + batch_case.name + ".tsv";
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            std::cerr << "Ошибка открытия файла: " << filename << std::endl;
+            return 1;
+        }
+        for (size_t k = 0; k < selected.size(); ++k) {
+            file << (k > 0 ? "\t" : "") << channelName(selected[k]);
+        }
+        file << "\n" << std::setprecision(10);
+        for (size_t i = 0; i < table.size(); ++i) {
+            for (size_t k = 0; k < columns.size(); ++k) {
+                file << (k > 0 ? "\t" : "") << columns[k][i];
+            }
+            file << "\n";
+        }
+        ++written;
+        
+        std::cout << batch_case.name << ": точек " << table.size() << ", столбцы "
+                  << table.capacityBytes() / 1024 << " КиБ (в TrajectoryPoint "
+                  << table.size() * sizeof(TrajectoryPoint) / 1024 << " КиБ)\n";
+    }
+    std::cout << "Сохранено " << written << " из " << cases.size() << " случаев в " << directory << "\n";
+    return 0;
+}
+
+// Замер задержки пошагового расчёта (realtime_stepper.h):
+//   trajectory_calc --rt-bench [cases.txt] [--rate Гц] [--steps N] [--method M]
+//                   [--atmosphere ...] [--aero ...] [--pitch ...] [--math ...]
+// Аппарат - первый случай cases.txt или основной случай программы.
+static int run_rt_bench_mode(int argc, char* argv[]) {
+    int first_option = 2;
+    VehicleParams params = {70.5, 40.0, 86.0, 2245.0, 3401.0, 0.035, 40.0, 3.57, 1255.0, 0.215, 0.14, 0.231};
+    if (argc > 2 && std::string(argv[2]).compare(0, 2, "--") != 0) {
+        try {
+            std::vector<BatchCase> cases = loadBatchCases(argv[2]);
+            if (cases.empty()) {
+                std::cerr << "Ошибка: в " << argv[2] << " нет случаев" << std::endl;
+                return 1;
+            }
+            params = cases.front().params;
+        } catch (const std::exception& e) {
+            std::cerr << "Ошибка: " << e.what() << std::endl;
+            return 1;
+        }
+        first_option = 3;
+    }
+    
+    RealtimeBenchOptions bench;
+    BatchOptions options;
+    for (int i = first_option; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key == "--rate") {
+            if (!parse_number(key, argv[i + 1], bench.rate)) return 1;
+        } else if (key == "--steps") {
+            if (!parse_number(key, argv[i + 1], bench.steps)) return 1;
+        } else if (key == "--method") {
+            if (!parseMethod(argv[i + 1], bench.method)) {
+                std::cerr << "Неизвестный метод: " << argv[i + 1] << std::endl;
+                return 1;
+            }
+        } else if (!parse_batch_option(key, argv[i + 1], options)) {
+            return 1;
+        }
+    }
+    if (!(bench.rate > 0.0) || bench.steps == 0) {
+        std::cerr << "Ошибка: --rate и --steps должны быть положительными" << std::endl;
+        return 1;
+    }
+    
+    TrajectoryCalculator calculator(params);
+    calculator.setAtmosphereProfile(options.atmosphere);
+    calculator.setAeroDatabase(options.aero);
+    calculator.setPitchDynamics(options.pitch);
+    calculator.setFastMath(options.fast_math);
+    return realtimeBenchmark(calculator, bench, std::cout) ? 0 : 1;
+}
+
+// Статистика разброса без сохранения траекторий (ensemble_stats.h):
+//   trajectory_calc --ensemble cases.txt [--times t1,t2,...] [--hist var:low:high:bins]...
+//                   [--accuracy a] [--out file] [параметры --batch] [--cache-mode full|end]
+// Для конечного состояния и состояний в моменты --times выводятся среднее,
+// СКО, квантили (погрешность --accuracy от модуля значения, по умолчанию 1e-5),
+// ковариация и гистограммы величин t, V, theta_c, x, y, omega_z, theta, m.
+// Результат не зависит от числа потоков. Без --times из кэша берутся только
+// конечные состояния, поэтому подходит и кэш --cache-mode end.
+static int run_ensemble_mode(int argc, char* argv[]) {
+    std::string cases_file = argv[2];
+    std::string out_file;
+    EnsembleStatsOptions stats_options;
+    BatchOptions options;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--times") {
+            std::istringstream in(value);
+            std::string item;
+            while (std::getline(in, item, ',')) {
+                double t = 0.0;
+                if (!parse_number(key, item, t)) return 1;
+                stats_options.times.push_back(t);
+            }
+        } else if (key == "--hist") {
+            HistogramSpec spec;
+            std::replace(value.begin(), value.end(), ':', ' ');
+            std::istringstream in(value);
+            if (!(in >> spec.variable >> spec.low >> spec.high >> spec.bins)) {
+                std::cerr << "Ошибка: --hist ожидает величина:low:high:bins" << std::endl;
+                return 1;
+            }
+            stats_options.histograms.push_back(spec);
+        } else if (key == "--accuracy") {
+            if (!parse_number(key, value, stats_options.relative_accuracy)) return 1;
+        } else if (key == "--out") {
+            out_file = value;
+        } else if (!parse_batch_option(key, value, options)) {
+            return 1;
+        }
+    }
+    if (!stats_options.times.empty() && !check_trajectory_cache(options, "--ensemble с --times")) {
+        return 1;
+    }
+    // Без --times статистике нужно только конечное состояние
+    options.end_state_only = stats_options.times.empty();
+    
+    std::vector<BatchCase> cases;
+    std::vector<EnsembleStats> stats;
+    try {
+        cases = loadBatchCases(cases_file);
+        // Свои накопители у каждого рабочего потока, объединение в конце
+        unsigned threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+        stats.assign(threads, EnsembleStats(stats_options));
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    runBatch(cases, options, [&](unsigned worker, size_t, const std::vector<TrajectoryPoint>& trajectory) {
+        stats[worker].add(trajectory);
+    });
+    for (size_t w = 1; w < stats.size(); ++w) {
+        stats.front().merge(stats[w]);
+    }
+    
+    std::ofstream file;
+    if (!out_file.empty()) {
+        file.open(out_file);
+        if (!file.is_open()) {
+            std::cerr << "Ошибка открытия файла: " << out_file << std::endl;
+            return 1;
+        }
+    }
+    stats.front().write(out_file.empty() ? std::cout : file);
+    return 0;
+}
+
+// Пакет в нескольких процессах (shard.h):
+//   trajectory_calc --sharded cases.txt --shards N [--workers P] [--retries R] [--out dir]
+//                   [параметры --batch, кроме --checkpoint]
+// Случаи делятся на N шардов, их считают до P процессов-исполнителей; упавший
+// исполнитель перезапускается до R раз (по умолчанию 2). Готовые файлы шардов
+// в <dir>/shards (по умолчанию results/sharded) не пересчитываются, поэтому
+// часть шардов можно посчитать на других машинах с общим каталогом:
+//   trajectory_calc --batch-worker cases.txt --shard K/N [--out dir] [те же параметры]
+// Объединённые end_states.txt, trajectories.bin и summary.txt не зависят от N.
+static int run_sharded_mode(int argc, char* argv[]) {
+    const bool worker = std::string(argv[1]) == "--batch-worker";
+    std::string cases_file = argv[2];
+    ShardOptions shard_options;
+    BatchOptions options;
+    unsigned shard = 0;
+    bool has_shard = false;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--out") {
+            shard_options.directory = value;
+        } else if (!worker && key == "--shards") {
+            if (!parse_number(key, value, shard_options.shards)) return 1;
+        } else if (!worker && key == "--workers") {
+            if (!parse_number(key, value, shard_options.workers)) return 1;
+        } else if (!worker && key == "--retries") {
+            if (!parse_number(key, value, shard_options.retries)) return 1;
+        } else if (worker && key == "--shard") {
+            char slash = 0;
+            std::istringstream in(value);
+            has_shard = static_cast<bool>(in >> shard >> slash >> shard_options.shards) && slash == '/';
+        } else if (key == "--checkpoint") {
+            std::cerr << "Ошибка: контрольные точки не используются, единица повтора - шард" << std::endl;
+            return 1;
+        } else {
+            if (!parse_batch_option(key, value, options)) {
+                return 1;
+            }
+            shard_options.batch_arguments.push_back(key);
+            shard_options.batch_arguments.push_back(value);
+        }
+    }
+    if (!check_trajectory_cache(options, worker ? "--batch-worker" : "--sharded")) {
+        return 1;
+    }
+    if (worker && (!has_shard || shard_options.shards == 0 || shard >= shard_options.shards)) {
+        std::cerr << "Ошибка: --batch-worker ожидает --shard K/N с 0 <= K < N" << std::endl;
+        return 1;
+    }
+    
+    std::vector<BatchCase> cases;
+    try {
+        cases = loadBatchCases(cases_file);
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    if (worker) {
+        unsigned long long fingerprint = shardFingerprint(cases, shard_options.batch_arguments);
+        return runShardWorker(cases, shard, shard_options.shards, options, fingerprint,
+                              shard_options.directory) ? 0 : 1;
+    }
+    
+    // Исполнители - этот же файл программы
+    std::error_code error;
+    std::string executable = std::filesystem::read_symlink("/proc/self/exe", error).string();
+    if (error) executable = argv[0];
+    
+    ShardReport report;
+    auto start = std::chrono::steady_clock::now();
+    bool ok = runShardedBatch(executable, cases_file, cases, shard_options, &report);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Шарды: " << shard_options.shards << ", запусков исполнителей " << report.launched
+              << " (повторов " << report.retried << "), готовых файлов " << report.reused << "\n";
+    if (!ok) {
+        std::cerr << "Ошибка: пакет не завершён" << std::endl;
+        return 1;
+    }
+    std::cout << "Пакет: объединено " << report.cases << " случаев (пустых " << report.failed_cases
+              << ") в " << shard_options.directory << " за " << std::fixed << std::setprecision(2)
+              << elapsed << " с\n";
+    return 0;
+}
+
+// Параллельный по времени расчёт одиночных траекторий:
+//   trajectory_calc --parareal cases.txt [--slices N] [--threads N] [--coarse-dt s] [--tolerance e]
+// Каждый случай считается последовательно и методом Parareal; выводятся число
+// итераций, ускорение и отличие конечного состояния. Траектории Parareal
+// сохраняются в results/parareal/<name>.txt.
+static int run_parareal_mode(int argc, char* argv[]) {
+    std::string cases_file = argv[2];
+    PararealOptions options;
+    for (int i = 3; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key == "--slices") {
+            if (!parse_number(key, argv[i + 1], options.slices)) return 1;
+        } else if (key == "--threads") {
+            if (!parse_number(key, argv[i + 1], options.threads)) return 1;
+        } else if (key == "--coarse-dt") {
+            if (!parse_number(key, argv[i + 1], options.coarse_dt)) return 1;
+        } else if (key == "--tolerance") {
+            if (!parse_number(key, argv[i + 1], options.tolerance)) return 1;
+        } else {
+            std::cerr << "Неизвестный параметр: " << key << std::endl;
+            return 1;
+        }
+    }
+    
+    std::vector<BatchCase> cases;
+    try {
+        cases = loadBatchCases(cases_file);
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    std::filesystem::create_directories("results/parareal");
+    for (const BatchCase& batch_case : cases) {
+        TrajectoryCalculator calculator(batch_case.params);
+        
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<TrajectoryPoint> serial;
+        calculator.calculateTrajectory(batch_case.method, batch_case.alpha_law, batch_case.dt, serial);
+        double serial_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        
+        std::vector<TrajectoryPoint> trajectory;
+        PararealReport report;
+        if (!calculateTrajectoryParareal(calculator, batch_case.method, batch_case.alpha_law, batch_case.dt,
+                                         options, trajectory, &report) || trajectory.empty() || serial.empty()) {
+            std::cerr << "Случай " << batch_case.name << ": расчёт не выполнен\n";
+            continue;
+        }
+        calculator.saveResultsToFile(trajectory, "results/parareal/" + batch_case.name + ".txt");
+        
+        // Наибольшее отличие конечного состояния от последовательного расчёта
+        const TrajectoryPoint& a = serial.back();
+        const TrajectoryPoint& b = trajectory.back();
+        double deviation = std::max({std::fabs(a.x - b.x), std::fabs(a.y - b.y), std::fabs(a.V - b.V)});
+        
+        std::cout << batch_case.name << ": отрезков " << report.slices
+                  << ", итераций " << report.iterations << (report.converged ? "" : " (без сходимости)")
+                  << std::fixed << std::setprecision(3)
+                  << ", последовательно " << serial_seconds << " с, Parareal " << report.wall_seconds << " с"
+                  << ", ускорение " << std::setprecision(2) << serial_seconds / report.wall_seconds
+                  << " (оценка " << report.speedup << ")"
+                  << std::scientific << std::setprecision(2) << ", отличие " << deviation
+                  << ", точек " << trajectory.size() << "/" << serial.size() << "\n" << std::defaultfloat;
+    }
+    return 0;
+}
+
+// Генерация случаев для исследования разброса:
+//   trajectory_calc --sample base.txt spread.txt [--sampler sobol|lhs] [--count N] [--skip K]
+//                   [--size N] [--seed S] [--out cases.txt]
+// base.txt - файл случаев (используется первый), spread.txt - законы параметров (sampling.h).
+// Шарды одной выборки задаются --skip; для lhs --size - полный размер гиперкуба.
+static int run_sample_mode(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Ожидается: --sample base.txt spread.txt [параметры]" << std::endl;
+        return 1;
+    }
+    SamplerKind kind = SAMPLER_SOBOL;
+    unsigned long long count = 1024, skip = 0, size = 0;
+    std::uint32_t seed = 1;
+    std::string out_file;
+    for (int i = 4; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key == "--sampler") {
+            if (!parseSamplerKind(argv[i + 1], kind)) {
+                std::cerr << "Неизвестный генератор: " << argv[i + 1] << std::endl;
+                return 1;
+            }
+        } else if (key == "--count") {
+            if (!parse_number(key, argv[i + 1], count)) return 1;
+        } else if (key == "--skip") {
+            if (!parse_number(key, argv[i + 1], skip)) return 1;
+        } else if (key == "--size") {
+            if (!parse_number(key, argv[i + 1], size)) return 1;
+        } else if (key == "--seed") {
+            if (!parse_number(key, argv[i + 1], seed)) return 1;
+        } else if (key == "--out") {
+            out_file = argv[i + 1];
+        } else {
+            std::cerr << "Неизвестный параметр: " << key << std::endl;
+            return 1;
+        }
+    }
+    if (size == 0) size = skip + count;
+    
+    std::vector<BatchCase> cases;
+    try {
+        std::vector<BatchCase> base = loadBatchCases(argv[2]);
+        if (base.empty()) {
+            std::cerr << "Ошибка: в " << argv[2] << " нет случаев" << std::endl;
+            return 1;
+        }
+        cases = sampleBatchCases(base.front(), loadDispersionSpec(argv[3]), kind, skip, count, size, seed);
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    std::ofstream file;
+    if (!out_file.empty()) {
+        file.open(out_file);
+        if (!file.is_open()) {
+            std::cerr << "Ошибка открытия файла: " << out_file << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = out_file.empty() ? std::cout : file;
+    for (const BatchCase& batch_case : cases) {
+        out << formatBatchCase(batch_case) << "\n";
+    }
+    return 0;
+}
+
+// Суррогатная модель конечного состояния (surrogate.h):
+//   trajectory_calc --surrogate-build base.txt grid.txt table.bin [--threads N]
+//   trajectory_calc --surrogate-query base.txt table.bin queries.txt [--max-error m]
+//       [--max-error-t s] [--max-error-V m/s] [--max-error-theta град] [--max-error-m кг]
+// base.txt - файл случаев (используется первый), queries.txt - файл случаев-запросов
+// (используются параметры ЛА). Для запроса выводится конечное состояние,
+// источник (T - таблица, I - расчёт) и время ответа в мкс. Таблица используется,
+// если ошибки ячейки по всем компонентам в пределах допусков (--max-error - положение).
+static int run_surrogate_mode(int argc, char* argv[]) {
+    const bool building = std::string(argv[1]) == "--surrogate-build";
+    if (argc < 5) {
+        std::cerr << "Ожидается: " << argv[1]
+                  << (building ? " base.txt grid.txt table.bin" : " base.txt table.bin queries.txt")
+                  << " [параметры]" << std::endl;
+        return 1;
+    }
+    unsigned threads = 0;
+    SurrogateTolerance tolerance;
+    for (int i = 5; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (building && key == "--threads") {
+            if (!parse_number(key, argv[i + 1], threads)) return 1;
+        } else if (!building && key == "--max-error") {
+            if (!parse_number(key, argv[i + 1], tolerance.position)) return 1;
+        } else if (!building && key == "--max-error-t") {
+            if (!parse_number(key, argv[i + 1], tolerance.t)) return 1;
+        } else if (!building && key == "--max-error-V") {
+            if (!parse_number(key, argv[i + 1], tolerance.V)) return 1;
+        } else if (!building && key == "--max-error-theta") {
+            if (!parse_number(key, argv[i + 1], tolerance.theta_c)) return 1;
+        } else if (!building && key == "--max-error-m") {
+            if (!parse_number(key, argv[i + 1], tolerance.m)) return 1;
+        } else {
+            std::cerr << "Неизвестный параметр: " << key << std::endl;
+            return 1;
+        }
+    }
+    
+    try {
+        std::vector<BatchCase> base = loadBatchCases(argv[2]);
+        if (base.empty()) {
+            std::cerr << "Ошибка: в " << argv[2] << " нет случаев" << std::endl;
+            return 1;
+        }
+        
+        TrajectorySurrogate surrogate;
+        if (building) {
+            SurrogateBuildReport report;
+            if (!TrajectorySurrogate::build(base.front(), loadSurrogateGrid(argv[3]), threads, surrogate, &report)) {
+                return 1;
+            }
+            if (!surrogate.save(argv[4])) {
+                std::cerr << "Ошибка записи таблицы: " << argv[4] << std::endl;
+                return 1;
+            }
+            std::cout << "Узлов " << report.nodes << ", ячеек " << report.cells
+                      << std::fixed << std::setprecision(2) << ", расчёт " << report.seconds << " с"
+                      << std::scientific << "\nОшибка ячеек (наибольшая / средняя):"
+                      << "\n  t " << report.max_error.t << " / " << report.mean_error.t << " с"
+                      << "\n  x " << report.max_error.x << " / " << report.mean_error.x << " м"
+                      << "\n  y " << report.max_error.y << " / " << report.mean_error.y << " м"
+                      << "\n  V " << report.max_error.V << " / " << report.mean_error.V << " м/с"
+                      << "\n  theta_c " << report.max_error.theta_c << " / " << report.mean_error.theta_c << " град"
+                      << "\n  m " << report.max_error.m << " / " << report.mean_error.m << " кг\n"
+                      << std::defaultfloat;
+            return 0;
+        }
+        
+        if (!TrajectorySurrogate::load(argv[3], base.front(), surrogate)) {
+            std::cerr << "Таблица " << argv[3] << " не загружена или построена для другого случая" << std::endl;
+            return 1;
+        }
+        std::vector<BatchCase> queries = loadBatchCases(argv[4]);
+        std::cout << std::setprecision(10);
+        for (const BatchCase& query : queries) {
+            auto t0 = std::chrono::steady_clock::now();
+            bool from_table = false;
+            SurrogateState s = surrogate.evaluate(query.params, tolerance, &from_table);
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+            std::cout << query.name << ' ' << s.t << ' ' << s.x << ' ' << s.y << ' ' << s.V << ' '
+                      << s.theta_c << ' ' << s.m << ' ' << (from_table ? 'T' : 'I') << ' ' << us << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
     #ifdef _WIN32
         // 65001 – кодовая страница UTF‑8
         SetConsoleOutputCP(65001);
@@ -21,6 +750,86 @@ int main() {
         _setmode(_fileno(stdout), _O_U16TEXT);
     #endif
     
+    // Вариант пакетных ядер: trajectory_calc --isa generic|sse4.2|avx2|avx512 [режим ...]
+    if (argc > 2 && std::string(argv[1]) == "--isa") {
+        if (!selectKernels(argv[2])) {
+            std::cerr << "Вариант ядер " << argv[2] << " неизвестен или не поддерживается процессором; доступны:";
+            for (const KernelSet* set : availableKernels()) std::cerr << " " << set->name;
+            std::cerr << std::endl;
+            return 1;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    
+    // Проверка вариантов ядер: trajectory_calc --isa-selftest
+    if (argc > 1 && std::string(argv[1]) == "--isa-selftest") {
+        return kernelSelfTest(std::cout) ? 0 : 1;
+    }
+    
+    // Проверка режима быстрой физики: trajectory_calc --fast-math-check
+    if (argc > 1 && std::string(argv[1]) == "--fast-math-check") {
+        return fastMathSelfTest(std::cout) ? 0 : 1;
+    }
+    
+    if (argc > 2 && std::string(argv[1]) == "--batch") {
+        return run_batch_mode(argc, argv);
+    }
+    
+    if (argc > 2 && std::string(argv[1]) == "--columns") {
+        return run_columns_mode(argc, argv);
+    }
+    
+    if (argc > 1 && std::string(argv[1]) == "--rt-bench") {
+        return run_rt_bench_mode(argc, argv);
+    }
+    
+    if (argc > 2 && std::string(argv[1]) == "--ensemble") {
+        return run_ensemble_mode(argc, argv);
+    }
+    
+    if (argc > 2 && (std::string(argv[1]) == "--sharded" || std::string(argv[1]) == "--batch-worker")) {
+        return run_sharded_mode(argc, argv);
+    }
+    
+    if (argc > 1 && std::string(argv[1]) == "--sample") {
+        return run_sample_mode(argc, argv);
+    }
+    
+    if (argc > 2 && std::string(argv[1]) == "--parareal") {
+        return run_parareal_mode(argc, argv);
+    }
+    
+    if (argc > 1 && (std::string(argv[1]) == "--surrogate-build" || std::string(argv[1]) == "--surrogate-query")) {
+        return run_surrogate_mode(argc, argv);
+    }
+    
+    // Сервис: trajectory_calc --serve <сокет | -> [--threads N]; протокол в trajectory_server.h
+    if (argc > 2 && std::string(argv[1]) == "--serve") {
+        ServerOptions options;
+        options.socket_path = argv[2];
+        if (argc > 4 && std::string(argv[3]) == "--threads" && !parse_number(argv[3], argv[4], options.threads)) {
+            return 1;
+        }
+        return runTrajectoryServer(options);
+    }
+    
+    // Клиент: запросы из stdin, ответы в stdout
+    if (argc > 2 && std::string(argv[1]) == "--client") {
+        return runTrajectoryClient(argv[2], std::cin, std::cout);
+    }
+    
+    // Основной расчёт: trajectory_calc [--downsample x,y,V] - прореживание сохраняемых файлов
+    DownsampleTolerance downsample;
+    const DownsampleTolerance* tolerance = nullptr;
+    if (argc > 2 && std::string(argv[1]) == "--downsample") {
+        if (!parse_downsample(argv[2], downsample)) {
+            return 1;
+        }
+        tolerance = &downsample;
+    }
+    
     // Создаем папку для результатов
     std::filesystem::create_directory("results");
 
@@ -58,161 +867,117 @@ int main() {
     TrajectoryCalculator calculator(V0, theta_c0, m_dot, W, y0, omega_z0, theta0,
                                     t_end, m0, I_d, S_a, S_m);
     
-    // Задание 1: Метод Эйлера
-    std::cout << "\nЗАДАНИЕ 1: МЕТОД ЭЙЛЕРА\n";
-    std::cout << "========================\n";
+    // Расчёт идёт в этом потоке, таблицы и файлы выводит поток записи (async_writer.h).
+    // Весь консольный вывод дальше проходит через него, чтобы сохранить порядок
+    // и форматирование; заголовки форматируются в задании, так как зависят
+    // от состояния потока после предыдущей таблицы.
+    AsyncWriter writer(std::cout);
+    auto print = [&writer](const std::string& text) {
+        writer.submit([text](std::ostream& out) { out << text; });
+    };
     
-    double dt_values_euler[] = {0.1, 0.01, 0.001};
-    for (double dt : dt_values_euler) {
-        std::cout << "\n1a. α = θ - θс, dt = " << dt << " с\n";
+    auto run_case = [&](IntegrationMethod method, AlphaLaw alpha_law, double dt,
+                        const std::string& title, const std::string& filename) {
+        writer.submit([title, dt](std::ostream& out) { out << title << dt << " с\n"; });
         try {
-            auto trajectory = calculator.calculateTrajectory(EULER, ALPHA_THETA_MINUS_THETAC, dt);
-            calculator.printResultsTable(trajectory);
-            
-            std::string filename = "results/euler_alpha_theta_dt_" + 
-                                  std::to_string(dt).substr(0,4);
-            calculator.saveResultsToFile(trajectory, filename + ".txt");
-            
-            // Сохраняем данные для графиков
-            calculator.saveGraphData(trajectory, filename + "_graph");
-            
-        } catch (const std::exception& e) {
-            std::cerr << "Ошибка: " << e.what() << std::endl;
-        }
-        
-        std::cout << "\n1b. α = 0, dt = " << dt << " с\n";
-        try {
-            auto trajectory = calculator.calculateTrajectory(EULER, ALPHA_ZERO, dt);
-            calculator.printResultsTable(trajectory);
-            
-            std::string filename = "results/euler_alpha_zero_dt_" + 
-                                  std::to_string(dt).substr(0,4);
-            calculator.saveResultsToFile(trajectory, filename + ".txt");
-            
-            // Сохраняем данные для графиков
-            calculator.saveGraphData(trajectory, filename + "_graph");
-            
+            auto trajectory = calculator.calculateTrajectory(method, alpha_law, dt);
+            writer.submit([&calculator, filename, tolerance, trajectory = std::move(trajectory)](std::ostream& out) {
+                try {
+                    calculator.printResultsTable(trajectory, out);
+                    calculator.saveResultsToFile(trajectory, filename + ".txt", tolerance, out);
+                    
+                    // Сохраняем данные для графиков
+                    calculator.saveGraphData(trajectory, filename + "_graph", tolerance, out);
+                    
+                } catch (const std::exception& e) {
+                    out.flush();
+                    std::cerr << "Ошибка: " << e.what() << std::endl;
+                }
+            });
         } catch (const std::exception& e) {
             std::cerr << "Ошибка: " << e.what() << std::endl;
         }
+    };
+    
+    // Задание 1: Метод Эйлера
+    print("\nЗАДАНИЕ 1: МЕТОД ЭЙЛЕРА\n"
+          "========================\n");
+    
+    double dt_values_euler[] = {0.1, 0.01, 0.001};
+    for (double dt : dt_values_euler) {
+        run_case(EULER, ALPHA_THETA_MINUS_THETAC, dt, "\n1a. α = θ - θс, dt = ",
+                 "results/euler_alpha_theta_dt_" + std::to_string(dt).substr(0,4));
+        run_case(EULER, ALPHA_ZERO, dt, "\n1b. α = 0, dt = ",
+                 "results/euler_alpha_zero_dt_" + std::to_string(dt).substr(0,4));
     }
     
     // Задание 2: Модифицированный метод Эйлера
-    std::cout << "\n\nЗАДАНИЕ 2: МОДИФИЦИРОВАННЫЙ МЕТОД ЭЙЛЕРА\n";
-    std::cout << "==========================================\n";
+    print("\n\nЗАДАНИЕ 2: МОДИФИЦИРОВАННЫЙ МЕТОД ЭЙЛЕРА\n"
+          "==========================================\n");
     
     double dt_values_modified[] = {0.1, 0.01};
     for (double dt : dt_values_modified) {
-        std::cout << "\n2a. α = θ - θс, dt = " << dt << " с\n";
-        try {
-            auto trajectory = calculator.calculateTrajectory(MODIFIED_EULER, ALPHA_THETA_MINUS_THETAC, dt);
-            calculator.printResultsTable(trajectory);
-            
-            std::string filename = "results/modified_euler_alpha_theta_dt_" + 
-                                  std::to_string(dt).substr(0,4);
-            calculator.saveResultsToFile(trajectory, filename + ".txt");
-            
-            // Сохраняем данные для графиков
-            calculator.saveGraphData(trajectory, filename + "_graph");
-            
-        } catch (const std::exception& e) {
-            std::cerr << "Ошибка: " << e.what() << std::endl;
-        }
-        
-        std::cout << "\n2b. α = 0, dt = " << dt << " с\n";
-        try {
-            auto trajectory = calculator.calculateTrajectory(MODIFIED_EULER, ALPHA_ZERO, dt);
-            calculator.printResultsTable(trajectory);
-            
-            std::string filename = "results/modified_euler_alpha_zero_dt_" + 
-                                  std::to_string(dt).substr(0,4);
-            calculator.saveResultsToFile(trajectory, filename + ".txt");
-            
-            // Сохраняем данные для графиков
-            calculator.saveGraphData(trajectory, filename + "_graph");
-            
-        } catch (const std::exception& e) {
-            std::cerr << "Ошибка: " << e.what() << std::endl;
-        }
+        run_case(MODIFIED_EULER, ALPHA_THETA_MINUS_THETAC, dt, "\n2a. α = θ - θс, dt = ",
+                 "results/modified_euler_alpha_theta_dt_" + std::to_string(dt).substr(0,4));
+        run_case(MODIFIED_EULER, ALPHA_ZERO, dt, "\n2b. α = 0, dt = ",
+                 "results/modified_euler_alpha_zero_dt_" + std::to_string(dt).substr(0,4));
     }
     
     // Задание 3: Метод Рунге-Кутта 4-го порядка
-    std::cout << "\n\nЗАДАНИЕ 3: МЕТОД РУНГЕ-КУТТА 4-ГО ПОРЯДКА\n";
-    std::cout << "===========================================\n";
+    print("\n\nЗАДАНИЕ 3: МЕТОД РУНГЕ-КУТТА 4-ГО ПОРЯДКА\n"
+          "===========================================\n");
     
     double dt_rk4 = 0.1;
-    
-    std::cout << "\n3a. α = θ - θс, dt = " << dt_rk4 << " с\n";
-    try {
-        auto trajectory = calculator.calculateTrajectory(RUNGE_KUTTA_4, ALPHA_THETA_MINUS_THETAC, dt_rk4);
-        calculator.printResultsTable(trajectory);
-        
-        std::string filename = "results/runge_kutta4_alpha_theta_dt_0.1";
-        calculator.saveResultsToFile(trajectory, filename + ".txt");
-        
-        // Сохраняем данные для графиков
-        calculator.saveGraphData(trajectory, filename + "_graph");
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Ошибка: " << e.what() << std::endl;
-    }
-    
-    std::cout << "\n3b. α = 0, dt = " << dt_rk4 << " с\n";
-    try {
-        auto trajectory = calculator.calculateTrajectory(RUNGE_KUTTA_4, ALPHA_ZERO, dt_rk4);
-        calculator.printResultsTable(trajectory);
-        
-        std::string filename = "results/runge_kutta4_alpha_zero_dt_0.1";
-        calculator.saveResultsToFile(trajectory, filename + ".txt");
-        
-        // Сохраняем данные для графиков
-        calculator.saveGraphData(trajectory, filename + "_graph");
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Ошибка: " << e.what() << std::endl;
-    }
+    run_case(RUNGE_KUTTA_4, ALPHA_THETA_MINUS_THETAC, dt_rk4, "\n3a. α = θ - θс, dt = ",
+             "results/runge_kutta4_alpha_theta_dt_0.1");
+    run_case(RUNGE_KUTTA_4, ALPHA_ZERO, dt_rk4, "\n3b. α = 0, dt = ",
+             "results/runge_kutta4_alpha_zero_dt_0.1");
     
     // Дополнительно: сравнительный анализ для шага 0.1 с
-    std::cout << "\n\nСРАВНИТЕЛЬНЫЙ АНАЛИЗ (шаг 0.1 с)\n";
-    std::cout << "================================\n";
-    
-    std::cout << "\nДля α = θ - θс, dt = 0.1 с:\n";
+    print("\n\nСРАВНИТЕЛЬНЫЙ АНАЛИЗ (шаг 0.1 с)\n"
+          "================================\n"
+          "\nДля α = θ - θс, dt = 0.1 с:\n");
     try {
         auto trajectory_euler = calculator.calculateTrajectory(EULER, ALPHA_THETA_MINUS_THETAC, 0.1);
         auto trajectory_modified = calculator.calculateTrajectory(MODIFIED_EULER, ALPHA_THETA_MINUS_THETAC, 0.1);
         auto trajectory_rk4 = calculator.calculateTrajectory(RUNGE_KUTTA_4, ALPHA_THETA_MINUS_THETAC, 0.1);
         
-        std::cout << "Метод Эйлера: конечная высота = " << trajectory_euler.back().y 
-                  << " м, скорость = " << trajectory_euler.back().V << " м/с\n";
-        std::cout << "Мод. Эйлера: конечная высота = " << trajectory_modified.back().y 
-                  << " м, скорость = " << trajectory_modified.back().V << " м/с\n";
-        std::cout << "Рунге-Кутта 4: конечная высота = " << trajectory_rk4.back().y 
-                  << " м, скорость = " << trajectory_rk4.back().V << " м/с\n";
-        
-        // Сохраняем сравнительные данные
-        std::ofstream comp_file("results/comparison_alpha_theta.txt");
-        if (comp_file.is_open()) {
-            comp_file << "Метод\tКонечное время (с)\tКонечная высота (м)\tКонечная скорость (м/с)\t"
-                     << "Конечная дальность (м)\tКонечная масса (кг)\n";
-            comp_file << "Эйлер\t" << trajectory_euler.back().t << "\t" 
-                     << trajectory_euler.back().y << "\t" << trajectory_euler.back().V << "\t"
-                     << trajectory_euler.back().x << "\t" << trajectory_euler.back().m << "\n";
-            comp_file << "Мод.Эйлер\t" << trajectory_modified.back().t << "\t" 
-                     << trajectory_modified.back().y << "\t" << trajectory_modified.back().V << "\t"
-                     << trajectory_modified.back().x << "\t" << trajectory_modified.back().m << "\n";
-            comp_file << "Рунге-Кутта4\t" << trajectory_rk4.back().t << "\t" 
-                     << trajectory_rk4.back().y << "\t" << trajectory_rk4.back().V << "\t"
-                     << trajectory_rk4.back().x << "\t" << trajectory_rk4.back().m << "\n";
-            comp_file.close();
-            std::cout << "Сравнительные данные сохранены в results/comparison_alpha_theta.txt\n";
-        }
+        // Нужны только конечные точки
+        writer.submit([euler = trajectory_euler.back(), modified = trajectory_modified.back(),
+                       rk4 = trajectory_rk4.back()](std::ostream& out) {
+            out << "Метод Эйлера: конечная высота = " << euler.y 
+                << " м, скорость = " << euler.V << " м/с\n";
+            out << "Мод. Эйлера: конечная высота = " << modified.y 
+                << " м, скорость = " << modified.V << " м/с\n";
+            out << "Рунге-Кутта 4: конечная высота = " << rk4.y 
+                << " м, скорость = " << rk4.V << " м/с\n";
+            
+            // Сохраняем сравнительные данные
+            std::ofstream comp_file("results/comparison_alpha_theta.txt");
+            if (comp_file.is_open()) {
+                comp_file << "Метод\tКонечное время (с)\tКонечная высота (м)\tКонечная скорость (м/с)\t"
+                         << "Конечная дальность (м)\tКонечная масса (кг)\n";
+                comp_file << "Эйлер\t" << euler.t << "\t" 
+                         << euler.y << "\t" << euler.V << "\t"
+                         << euler.x << "\t" << euler.m << "\n";
+                comp_file << "Мод.Эйлер\t" << modified.t << "\t" 
+                         << modified.y << "\t" << modified.V << "\t"
+                         << modified.x << "\t" << modified.m << "\n";
+                comp_file << "Рунге-Кутта4\t" << rk4.t << "\t" 
+                         << rk4.y << "\t" << rk4.V << "\t"
+                         << rk4.x << "\t" << rk4.m << "\n";
+                comp_file.close();
+                out << "Сравнительные данные сохранены в results/comparison_alpha_theta.txt\n";
+            }
+        });
         
     } catch (const std::exception& e) {
         std::cerr << "Ошибка при сравнении: " << e.what() << std::endl;
     }
     
-    std::cout << "\nРАСЧЕТ ЗАВЕРШЕН!\n";
-    std::cout << "Все результаты сохранены в папке 'results/'\n\n";
+    print("\nРАСЧЕТ ЗАВЕРШЕН!\n"
+          "Все результаты сохранены в папке 'results/'\n\n");
+    writer.flush();
     
     return 0;
 }
\ No newline at end of file